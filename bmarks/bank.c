@@ -144,10 +144,10 @@ total(bank_t* bank, int transactional)
     {
       TX_START;
       total = 0;
+      TX_LOAD_RANGE(bank->accounts, bank->size * sizeof(account_t));
       for (i = 0; i < bank->size; i++)
 	{
-	  int *bal = (int*) TX_LOAD(&bank->accounts[i].balance); 
-	  total += *bal;
+	  total += bank->accounts[i].balance;
 	}
       TX_COMMIT;
     }
@@ -27,6 +27,7 @@
 #include <getopt.h>
 #include <limits.h>
 #include <signal.h>
+#include <malloc.h>
 
 #include "tm2c.h"
 
@@ -125,7 +126,7 @@ total(bank_t* bank, int transactional)
     }
   else 
     {
-      TX_START;
+      TX_START_RO;
       total = 0;
       for (i = 0; i < bank->size; i++) 
 	{
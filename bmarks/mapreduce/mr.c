@@ -334,16 +334,10 @@ size_t cc;
 static inline size_t
 get_next_chunk(int* chunk_index)
 {
-  size_t ci;
-
   /* cc +=  (NUM_UES - 1); */
   /* ci = cc; */
 
-  TX_START;
-  TX_LOAD_STORE(chunk_index, +, 1, TYPE_INT);
-  ci = *chunk_index;
-  TX_COMMIT_NO_PUB;
-  return ci;
+  return NONTX_FETCH_ADD(chunk_index, 1, TYPE_INT);
 }
 
 
@@ -409,10 +403,7 @@ map_reduce(FILE *fp, int *chunk_index, int *stats, int* chunks_per_core, char* f
       PF_STOP(0);
 
 
-      TX_START;
-      TX_LOAD_STORE(chunk_index, +, 1, TYPE_INT);
-      ci = *chunk_index;
-      TX_COMMIT_NO_PUB;
+      ci = get_next_chunk(chunk_index);
     }
   rewind(fp);
 #endif
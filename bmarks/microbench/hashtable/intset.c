@@ -256,9 +256,9 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 
 	  /* Physically removing */
 	  nxt_t nxt1 = *(nxt_t *) TX_LOAD(&next1->next);
-	  TX_STORE(&prev1->next, nxt1, TYPE_INT);
+	  TX_STORE(&prev1->next, nxt1, TYPE_INT64);
 	  nxt_t nxt2 = OF(new_node(val2, OF(next), transactional));
-	  TX_STORE(&prev->next, nxt2, TYPE_INT);
+	  TX_STORE(&prev->next, nxt2, TYPE_INT64);
 	  TX_SHFREE(next1);
 	}
     }
@@ -133,6 +133,36 @@ extern "C" {
       WRITE
     } RW;
 
+#if defined(INVISIBLE_READS) && defined(PGAS)
+#  error "INVISIBLE_READS is not supported with PGAS"
+#endif
+
+#if defined(PGAS_MVCC) && (!defined(PGAS) || defined(SCC) || defined(PLATFORM_TILERA))
+#  error "PGAS_MVCC is supported only with PGAS on the shared-memory platforms"
+#endif
+
+  /* DSL_NODE_WORKERS: the list of the number of workers (dsl cores) of
+     every DSL node */
+#if defined(DSL_NODE_WORKERS)
+#  define DSL_NUM_PARTITIONS (sizeof((uint8_t[]) { DSL_NODE_WORKERS }) / sizeof(uint8_t))
+#endif
+
+#if (ADDR_TO_DSL_SEL == 2) && (defined(PGAS) || defined(SCC) || defined(PLATFORM_TILERA))
+#  error "ADDR_TO_DSL_SEL = 2 is supported only without PGAS on the shared-memory platforms"
+#endif
+
+#if defined(DSL_NODE_WORKERS) && defined(PGAS)
+#  error "DSL_NODE_WORKERS is not supported with PGAS"
+#endif
+
+  /* range read locks: a reader of a range is registered on the (odd, thus
+     never a word address) key of every RANGE_LOCK_SIZE region of the range */
+#if defined(RANGE_LOCK_SIZE) && (RANGE_LOCK_SIZE > 0) && !defined(PGAS) && !defined(PLATFORM_TILERA)
+#  define TM2C_RANGE_LOCKS
+#  define TM2C_RANGE_WORD         sizeof(int32_t)
+#  define TM2C_RANGE_KEY(addr)    (((addr) & ~((tm_intern_addr_t) RANGE_LOCK_SIZE - 1)) | 0x1)
+#endif
+
   extern nodeid_t TM2C_ID;
   extern nodeid_t NUM_UES;
   extern nodeid_t NUM_APP_NODES;
@@ -218,6 +248,7 @@ extern "C" {
 #endif	/* PLATFORM_TILERA */
 
 #include "measurements.h"
+#include "tm2c_stats.h"
 
   /*  ------- Plug platform related things here BEGIN ------- */
 #if defined(PLATFORM_SCC)	
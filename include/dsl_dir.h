@@ -0,0 +1,134 @@
+/*
+ *   File: dsl_dir.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: directory-based address to DSL node mapping with
+ *                online rebalancing (ADDR_TO_DSL_SEL = 2)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * The addresses are hashed (after shifting by ADDR_SHIFT_MASK) to one of
+ * DSL_DIR_SIZE regions, and a shared-memory directory maps every region to
+ * a DSL node. The DSL nodes count the lock requests per region.
+ *
+ * Every DSL_DIR_PERIOD_MS, the first app node that starts a transaction
+ * rebalances: it freezes the starting of new transactions, waits until no
+ * app node is within a transaction (thus no locks are held for any region),
+ * moves hot regions from the most to the least loaded DSL nodes, and
+ * unfreezes. The non-transactional RPCs (e.g., NONTX_RMW) count as
+ * transactions for the quiescence. The loads are halved on every rebalancing.
+ */
+
+#ifndef DSL_DIR_H
+#define	DSL_DIR_H
+
+#include "common.h"
+#include "hash.h"
+
+#if (ADDR_TO_DSL_SEL == 2)
+
+#  if !defined(DSL_DIR_SIZE)
+#    define DSL_DIR_SIZE 4096	/* power of 2 */
+#  endif
+#  if !defined(DSL_DIR_PERIOD_MS)
+#    define DSL_DIR_PERIOD_MS 20
+#  endif
+
+#define DSL_DIR_MAX_MOVES    8	/* regions moved per rebalancing */
+#define DSL_DIR_REGION(addr) (hash_tw((addr) >> ADDR_SHIFT_MASK) & (DSL_DIR_SIZE - 1))
+
+typedef struct ALIGNED(CACHE_LINE_SIZE) dsl_dir_app
+{
+  volatile uint32_t in_tx;
+} dsl_dir_app_t;
+
+typedef struct dsl_dir
+{
+  volatile uint32_t freeze;	/* a rebalancing is in progress */
+  volatile uint32_t lock;	/* of the rebalancer */
+  volatile ticks next;		/* time of the next rebalancing */
+  uint32_t num_nodes;
+  uint32_t rebalances;
+  uint32_t moves;
+  uint8_t padding[CACHE_LINE_SIZE - 5 * sizeof(uint32_t) - sizeof(ticks)];
+  volatile nodeid_t node[DSL_DIR_SIZE];	/* region -> dsl node */
+  volatile uint32_t load[DSL_DIR_SIZE];	/* requests (approximate) */
+  dsl_dir_app_t app[];		/* one per node */
+} dsl_dir_t;
+
+extern dsl_dir_t* dsl_dir;
+
+extern void dsl_dir_init(nodeid_t num_nodes);
+extern void dsl_dir_term();
+extern void dsl_dir_rebalance();
+
+INLINED nodeid_t
+dsl_dir_node(tm_intern_addr_t addr)
+{
+  return dsl_dir->node[DSL_DIR_REGION(addr)];
+}
+
+/* dsl side: not atomic, the workers of a node may lose some counts */
+INLINED void
+dsl_dir_count(tm_intern_addr_t addr)
+{
+  dsl_dir->load[DSL_DIR_REGION(addr)]++;
+}
+
+/* app side: on the first start of a transaction (not on restarts), and
+   around the non-transactional RPCs outside transactions. static, as it
+   calls the static getticks and wait_cycles */
+static inline void
+dsl_dir_tx_start()
+{
+  volatile uint32_t* in_tx = &dsl_dir->app[NODE_ID()].in_tx;
+  while (1)
+    {
+      if (getticks() > dsl_dir->next && !dsl_dir->lock)
+	{
+	  dsl_dir_rebalance();
+	}
+
+      while (dsl_dir->freeze)
+	{
+	  wait_cycles(64);
+	}
+
+      /* the rebalancer sets freeze and then reads in_tx */
+      *in_tx = 1;
+      __sync_synchronize();
+      if (!dsl_dir->freeze)
+	{
+	  break;
+	}
+      *in_tx = 0;
+    }
+}
+
+static inline void
+dsl_dir_tx_end()
+{
+  __sync_synchronize();
+  dsl_dir->app[NODE_ID()].in_tx = 0;
+}
+
+#endif	/* ADDR_TO_DSL_SEL == 2 */
+
+#endif	/* DSL_DIR_H */
@@ -0,0 +1,77 @@
+/*
+ *   File: dsl_waitq.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: DSL-side wait queue for the requests that conflict on
+ *                hot addresses (DSL_WAITQ)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Every DSL core counts the conflicts per address in a small direct-mapped
+ * table (the entries of the lock table are released when they are not
+ * locked, thus they cannot keep the counts). A TM2C_RPC_LOAD or
+ * TM2C_RPC_STORE that conflicts on an address with at least DSL_WAITQ_HOT
+ * conflicts is not answered with an abort, but queued: the requester keeps
+ * its locks and waits for the reply.
+ *
+ * The queued requests are retried, in FIFO order, once after every
+ * received request (that might have released the lock), and are answered
+ * as soon as they succeed. A request is queued only while all the holders
+ * of the address have lower ids than the requester, so the waits cannot
+ * form a cycle (on any DSL cores), and it is aborted if it still conflicts
+ * DSL_WAITQ_TIMEOUT cycles after it was first queued.
+ */
+
+#ifndef DSL_WAITQ_H
+#define	DSL_WAITQ_H
+
+#include "common.h"
+#include "tm2c_rpc.h"
+
+#if defined(DSL_WAITQ)
+
+#  if !defined(DSL_WAITQ_HOT)
+#    define DSL_WAITQ_HOT      4	/* conflicts for an address to be hot */
+#  endif
+#  if !defined(DSL_WAITQ_TIMEOUT)
+#    define DSL_WAITQ_TIMEOUT  100000 /* cycles */
+#  endif
+
+#define DSL_WAITQ_HOT_SIZE     256	/* power of 2 */
+
+extern void dsl_waitq_init();
+extern void dsl_waitq_term();
+
+/* the request of sender conflicted. Returns TRUE if it was queued (it is
+   answered when it is retried), else it has to be aborted */
+extern uint32_t dsl_waitq_defer(nodeid_t sender, TM2C_RPC_REQ* req);
+
+/* copies to req a queued request that has to be retried and its sender to
+   sender. Returns FALSE if there is none: a new request has to be received */
+extern uint32_t dsl_waitq_retry(TM2C_RPC_REQ* req, nodeid_t* sender);
+
+#if defined(STATS_EXPORT)
+/* adds the occupancy of the queue to the stats record being written */
+extern void dsl_waitq_stats_export();
+#endif
+
+#endif	/* DSL_WAITQ */
+
+#endif	/* DSL_WAITQ_H */
@@ -0,0 +1,123 @@
+/*
+ *   File: oaht.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: open-addressing, resizable hashtable for the DSL service
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * The table is an array of cache-line groups of (address, record) slots,
+ * probed linearly group by group. The rw entries live in records that are
+ * allocated from a pool and never move, so that the ssht logs can point to
+ * them. A record is released (its slot becomes a tombstone) when it has no
+ * readers and no writer.
+ *
+ * When the used (live + tombstone) slots exceed 3/4 of the table, a new
+ * table is allocated (double the size if more than half of the slots are
+ * live, half if less than 1/8, else the same size to reclaim the tombstones)
+ * and the groups of the old one are migrated a few at a time on every
+ * insertion. Lookups search both tables while migrating.
+ */
+
+#ifndef _OAHT_H_
+#define _OAHT_H_
+
+#include "common.h"
+#include "hash.h"
+#include "ssht.h"
+#include "ssht_log.h"
+
+#if !defined(OAHT_INIT_GROUPS)
+#  define OAHT_INIT_GROUPS 64	/* power of 2 */
+#endif
+
+#define OAHT_GROUP_SLOTS   4
+#define OAHT_MIGRATE_STEP  2	/* groups migrated per insertion */
+#define OAHT_REC_CHUNK     64	/* records allocated at once */
+#define OAHT_EMPTY         ((addr_t) 0)
+#define OAHT_TOMBSTONE     (~((addr_t) 0))
+
+typedef struct ALIGNED(CACHE_LINE_SIZE) oaht_rec
+{
+  ssht_rw_entry_t entry;	/* first: the logs point to it */
+  addr_t addr;
+  struct oaht_rec* next_free;
+} oaht_rec_t;
+
+typedef struct ALIGNED(CACHE_LINE_SIZE) oaht_group
+{
+  addr_t addr[OAHT_GROUP_SLOTS];
+  oaht_rec_t* rec[OAHT_GROUP_SLOTS];
+} oaht_group_t;
+
+typedef struct oaht_table
+{
+  oaht_group_t* groups;
+  uint32_t num_groups;
+  uint32_t live;
+  uint32_t tombstones;
+} oaht_table_t;
+
+typedef struct oaht
+{
+  oaht_table_t cur;
+  oaht_table_t old;		/* being migrated to cur if groups != NULL */
+  uint32_t migrate_next;
+  oaht_rec_t* pinned;		/* the record of the ongoing insertion */
+  oaht_rec_t* free_recs;
+  oaht_rec_t** chunks;
+  uint32_t num_chunks;
+  uint32_t size_chunks;
+  uint32_t resizes;
+} oaht_t;
+
+typedef oaht_t* oaht_hashtable_t;
+
+extern oaht_hashtable_t oaht_new();
+extern void oaht_free(oaht_hashtable_t ht);
+
+extern ssht_rw_entry_t* oaht_lookup(oaht_hashtable_t ht, uintptr_t addr);
+extern TM2C_CONFLICT_T oaht_insert(oaht_hashtable_t ht, ssht_log_set_t* log, uint32_t id, uintptr_t addr, RW rw);
+/* the entry has no readers and no writer */
+extern void oaht_release(oaht_hashtable_t ht, ssht_rw_entry_t* entry);
+
+extern void oaht_stats_print(oaht_hashtable_t ht, uint32_t details);
+
+INLINED void
+oaht_remove_any(oaht_hashtable_t ht, uint32_t id, ssht_rw_entry_t* entry)
+{
+  if (ssht_rw_entry_remove(entry, id))
+    {
+      oaht_release(ht, entry);
+    }
+}
+
+/* releases rw of node id on the entry (found with oaht_lookup). The log
+   entry of the node is left behind (see ssht_rw_entry_holds) */
+INLINED void
+oaht_remove(oaht_hashtable_t ht, uint32_t id, ssht_rw_entry_t* entry, RW rw)
+{
+  if (ssht_rw_entry_remove_rw(entry, id, rw))
+    {
+      oaht_release(ht, entry);
+    }
+}
+
+#endif	/* _OAHT_H_ */
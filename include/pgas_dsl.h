@@ -41,7 +41,7 @@ extern void pgas_dsl_init();
 extern void pgas_dsl_term();
 
 extern int64_t pgas_dsl_read(uint64_t offset);
-inline int64_t* pgas_dsl_readp(uint64_t offset);
+extern int64_t* pgas_dsl_readp(uint64_t offset);
 extern int32_t pgas_dsl_read32(uint64_t offset);
 
 extern void pgas_dsl_write(uint64_t offset, int64_t val);
@@ -0,0 +1,112 @@
+/*
+ *   File: pgas_mvcc.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: multi-version snapshot reads for PGAS
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Every update transaction takes a commit timestamp from a global (shared
+ * memory) clock right before it starts persisting, and publishes it in its
+ * commit_ts slot until it has released its locks. When the DSL persists a
+ * word, it keeps the overwritten value in a bounded per-word history,
+ * stamped with the timestamp of the transaction that had written it.
+ *
+ * A read-only transaction (TX_START_RO) reads the clock (its snapshot) and
+ * then reads every word at the DSL without registering in the lock table:
+ * the DSL returns the latest version that is not newer than the snapshot.
+ * If the word is write-locked by a transaction that is committing within
+ * the snapshot, or the needed version has been evicted from the history,
+ * the read fails with a conflict and the read-only transaction restarts
+ * with a new snapshot.
+ */
+
+#ifndef PGAS_MVCC_H
+#define	PGAS_MVCC_H
+
+#include "common.h"
+#include "pgas_dsl.h"
+
+#if defined(PGAS_MVCC)
+
+#  if !defined(PGAS_MVCC_VERSIONS)
+#    define PGAS_MVCC_VERSIONS 4
+#  endif
+
+/* values of a commit_ts slot (other than a commit timestamp) */
+#define PGAS_MVCC_IDLE          0
+#define PGAS_MVCC_PENDING       (~0ULL)
+
+/* TM2C_RPC_LOAD_SNAPSHOT carries the snapshot and the #words (1 or 2) in num_words */
+#define PGAS_MVCC_PACK(snapshot, words)   (((snapshot) << 1) | ((words) == 1))
+#define PGAS_MVCC_SNAPSHOT(packed)        ((packed) >> 1)
+#define PGAS_MVCC_WORDS(packed)           (((packed) & 0x1) ? 1 : 2)
+
+typedef struct pgas_mvcc_shmem
+{
+  volatile uint64_t clock;
+  uint8_t padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+  volatile uint64_t commit_ts[];	/* one per node */
+} pgas_mvcc_shmem_t;
+
+extern pgas_mvcc_shmem_t* pgas_mvcc_shmem;
+
+extern void pgas_mvcc_init();
+extern void pgas_mvcc_term();
+
+/* app side ----------------------------------------------------------------- */
+
+INLINED uint64_t
+pgas_mvcc_snapshot()
+{
+  return pgas_mvcc_shmem->clock;
+}
+
+/* a DSL that sees PENDING cannot know on which side of a snapshot the
+   commit will be, so the slot is PENDING while taking the timestamp */
+INLINED void
+pgas_mvcc_commit_start()
+{
+  volatile uint64_t* slot = pgas_mvcc_shmem->commit_ts + NODE_ID();
+  *slot = PGAS_MVCC_PENDING;
+  *slot = __sync_add_and_fetch(&pgas_mvcc_shmem->clock, 1);
+}
+
+INLINED void
+pgas_mvcc_commit_end()
+{
+  pgas_mvcc_shmem->commit_ts[NODE_ID()] = PGAS_MVCC_IDLE;
+}
+
+/* dsl side ----------------------------------------------------------------- */
+
+/* persist val, keeping the previous version in the history of the word */
+extern void pgas_mvcc_write(uint64_t offset, int64_t val, nodeid_t writer);
+/* persist val as a transaction of its own (TM2C_RPC_RMW_NONTX), with a new
+   commit timestamp */
+extern void pgas_mvcc_write_nontx(uint64_t offset, int64_t val);
+/* read the version of the word in the snapshot. writer is the node that
+   holds the write lock on the word, or -1 */
+extern TM2C_CONFLICT_T pgas_mvcc_read(uint64_t offset, uint64_t packed,
+				      int32_t writer, int64_t* val);
+
+#endif	/* PGAS_MVCC */
+
+#endif	/* PGAS_MVCC_H */
@@ -0,0 +1,155 @@
+/*
+ *   File: reader_set.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: the set of the readers of a DSL entry (a bitmap of
+ *                TM2C_MAX_PROCS bits plus a list of up to 3 readers)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Membership is a bit test on the bitmap. Most entries have very few
+ * readers, so while there are up to READER_SET_LIST of them they are also
+ * kept in a list, and fetching the readers (for the contention manager)
+ * copies the list instead of scanning the bitmap. With more readers, the
+ * bitmap is scanned word by word (ctz), skipping the empty words. The list
+ * is rebuilt from the bitmap when a removal brings the readers back to
+ * READER_SET_LIST.
+ */
+
+#ifndef _READER_SET_H_
+#define _READER_SET_H_
+
+#include <inttypes.h>
+
+#include "common.h"
+
+#define READER_SET_WORDS ((TM2C_MAX_PROCS + 63) / 64)
+#define READER_SET_LIST  3
+
+typedef struct reader_set
+{
+  uint64_t bits[READER_SET_WORDS];
+  uint16_t nr;			/* number of readers */
+  uint16_t list[READER_SET_LIST]; /* the readers if nr <= READER_SET_LIST */
+} reader_set_t;
+
+#define reader_set_word(id)  ((id) >> 6)
+#define reader_set_bit(id)   (1ULL << ((id) & 63))
+
+INLINED uint32_t
+reader_set_is_member(reader_set_t* rs, uint32_t id)
+{
+  return (rs->bits[reader_set_word(id)] & reader_set_bit(id)) != 0;
+}
+
+/* whether there is any reader other than id */
+INLINED uint32_t
+reader_set_has_others(reader_set_t* rs, uint32_t id)
+{
+  return rs->nr > 1 || (rs->nr == 1 && rs->list[0] != id);
+}
+
+/* stores the ids of the (at most max) readers of the bitmap that are in
+   words [0, num_words) to ids. Returns their number */
+INLINED uint32_t
+reader_set_scan(uint64_t* bits, uint32_t num_words, nodeid_t* ids, uint32_t max)
+{
+  uint32_t w, n = 0;
+  for (w = 0; w < num_words && n < max; w++)
+    {
+      uint64_t word = bits[w];
+      while (word != 0 && n < max)
+	{
+	  ids[n++] = (w << 6) + __builtin_ctzll(word);
+	  word &= word - 1;
+	}
+    }
+  return n;
+}
+
+/* stores the ids of the readers to ids (of TM2C_MAX_PROCS). Returns their
+   number */
+INLINED uint32_t
+reader_set_fetch(reader_set_t* rs, nodeid_t* ids)
+{
+  if (rs->nr <= READER_SET_LIST)
+    {
+      uint32_t i;
+      for (i = 0; i < rs->nr; i++)
+	{
+	  ids[i] = rs->list[i];
+	}
+      return rs->nr;
+    }
+  return reader_set_scan(rs->bits, READER_SET_WORDS, ids, TM2C_MAX_PROCS);
+}
+
+/* returns TRUE if id was not a reader */
+INLINED uint32_t
+reader_set_insert(reader_set_t* rs, uint32_t id)
+{
+  uint64_t* word = rs->bits + reader_set_word(id);
+  if (*word & reader_set_bit(id))
+    {
+      return 0;
+    }
+
+  *word |= reader_set_bit(id);
+  if (rs->nr < READER_SET_LIST)
+    {
+      rs->list[rs->nr] = id;
+    }
+  rs->nr++;
+  return 1;
+}
+
+/* returns TRUE if id was a reader */
+INLINED uint32_t
+reader_set_remove(reader_set_t* rs, uint32_t id)
+{
+  uint64_t* word = rs->bits + reader_set_word(id);
+  if (!(*word & reader_set_bit(id)))
+    {
+      return 0;
+    }
+
+  *word &= ~reader_set_bit(id);
+  if (rs->nr <= READER_SET_LIST)
+    {
+      uint32_t i;
+      for (i = 0; rs->list[i] != id; i++)
+	;
+      rs->list[i] = rs->list[rs->nr - 1];
+    }
+  rs->nr--;
+
+  if (rs->nr == READER_SET_LIST)
+    {
+      nodeid_t ids[READER_SET_LIST];
+      uint32_t i, n = reader_set_scan(rs->bits, READER_SET_WORDS, ids, READER_SET_LIST);
+      for (i = 0; i < n; i++)
+	{
+	  rs->list[i] = ids[i];
+	}
+    }
+  return 1;
+}
+
+#endif	/* _READER_SET_H_ */
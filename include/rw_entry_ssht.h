@@ -51,6 +51,7 @@ extern "C" {
   {
     uint64_t readers;
     uint8_t writer;
+    uint8_t idx;		/* in the bucket */
   } ssht_rw_entry_t;
 
   /*___________________________________________________________________________________________________
@@ -138,24 +139,19 @@ extern "C" {
     return (BOOLEAN) (tmp.readers == rwe->readers);
   }
 
-  INLINED void
-  rw_entry_ssht_fetch_readers(ssht_rw_entry_t* rwe, uint8_t* readers) 
+  /* stores the ids of the readers to readers; returns their number */
+  INLINED uint32_t
+  rw_entry_ssht_fetch_readers(ssht_rw_entry_t* rwe, nodeid_t* readers) 
   {
     uint64_t convert = rwe->readers;
 
-    int i;
-    for (i = 0; i < NUM_UES; i++) 
+    uint32_t n = 0;
+    while (convert != 0) 
       {
-	if (convert & 0x01) 
-	  {
-	    readers[i] = 1;
-	  }
-	else 
-	  {
-	    readers[i] = 0;
-	  }
-	convert >>= 1;
+	readers[n++] = __builtin_ctzll(convert);
+	convert &= convert - 1;
       }
+    return n;
   }
 
   INLINED void
@@ -28,14 +28,24 @@
 #include <sys/time.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <stddef.h>
 
 #include "common.h"
 #include "hash.h"
+#include "tag_probe.h"
 
 #include "ssht_log.h"
 
+#if defined(BIT_OPTS)
+#define MAX_READERS 64
+#else
+#define MAX_READERS TM2C_MAX_PROCS
+#endif	/* BIT_OPTS */
+
 #if defined(BIT_OPTS)
 #include "rw_entry_ssht.h"
+#else
+#include "reader_set.h"
 #endif	/* BIT_OPTS */
 
 #include <assert.h>
@@ -48,18 +58,16 @@
 #define ENTRY_PER_CL ADDR_PER_CL
 
 #ifdef SCC
-#define PADDING_BYTES (64 - (ADDR_PER_CL+1)*4)
+#define PADDING_BYTES (64 - (ADDR_PER_CL+1)*4 - TAG_PROBE_WIDTH)
 #else
 #define PADDING_BYTES 0
 #endif	/* SCC */
 
 #if defined(BIT_OPTS)
-#define MAX_READERS 64
+#  define SSHT_NO_WRITER 0xFF
 #else
-#define MAX_READERS TM2C_MAX_PROCS
+#  define SSHT_NO_WRITER 0xFFFF
 #endif	/* BIT_OPTS */
-
-#define SSHT_NO_WRITER 0xFF
 #if defined(SCC)
 #  define SSHT_ENTRY_FREE 0x000000FF
 #else
@@ -75,12 +83,18 @@
 
 typedef uintptr_t addr_t;
 
+/* the 1-byte fingerprint of an address in the tags of its bucket (never 0,
+   which is a free slot). Folds the bits above the bucket index (with PGAS,
+   the low 6 bits of the addresses of a bucket are equal) */
+#define SSHT_TAG(addr)      ((uint8_t) (((addr) >> 3) ^ ((addr) >> 10)) | 0x80)
+#define SSHT_TAG_VALID      ((1U << ADDR_PER_CL) - 1)
+
 #if !defined(BIT_OPTS)
 typedef struct ALIGNED(CACHE_LINE_SIZE) ssht_rw_entry 
 {
-  uint8_t nr;
-  uint8_t reader[MAX_READERS];
-  uint8_t writer;
+  reader_set_t readers;
+  uint16_t writer;
+  uint8_t idx;			/* in the bucket */
 } ssht_rw_entry_t;
 #endif	/* !BIT_OPTS */
 
@@ -88,6 +102,7 @@ typedef struct ALIGNED(CACHE_LINE_SIZE) bucket
 {         
   addr_t addr[ADDR_PER_CL];	             
   struct bucket* next;			     
+  uint8_t tag[TAG_PROBE_WIDTH];	/* SSHT_TAG(addr[i]), or 0 if addr[i] is free */
   uint8_t padding[PADDING_BYTES];
   ssht_rw_entry_t entry[ENTRY_PER_CL];
 } bucket_t;
@@ -111,6 +126,7 @@ extern void ssht_stats_print(ssht_hashtable_t ht, uint32_t details);
 
 extern TM2C_CONFLICT_T bucket_insert_r(bucket_t* bu, ssht_log_set_t* log, uint32_t id, uintptr_t addr); 
 extern TM2C_CONFLICT_T bucket_insert_w(bucket_t* bu, ssht_log_set_t* log, uint32_t id, uintptr_t addr);
+extern ssht_rw_entry_t* bucket_lookup(bucket_t* bu, uintptr_t addr);
 
 INLINED bucket_t* 
 ssht_bucket_new() 
@@ -125,15 +141,183 @@ ssht_bucket_new()
   for (i = 0; i < ENTRY_PER_CL; i++) 
     {
       bu->entry[i].writer = SSHT_NO_WRITER;
+      bu->entry[i].idx = i;
     }
 
   return bu;
 }
 
+/* the bucket of an entry (the logs only keep the addr and the entry) */
+#define ssht_bucket_of(entry)						\
+  ((bucket_t*) ((uint8_t*) ((entry) - (entry)->idx) - offsetof(bucket_t, entry)))
+
+
+#if defined(BIT_OPTS)
+#  define ssht_rw_entry_has_readers(entry) rw_entry_ssht_has_readers(entry)
+#  define ssht_rw_entry_is_free(entry) rw_entry_ssht_is_empty(entry)
+#  define ssht_rw_entry_has_other_readers(entry, id)			\
+  (rw_entry_ssht_has_readers(entry) && !rw_entry_ssht_is_unique_reader(entry, id))
+/* the ids of the readers (for the contention manager); returns their number */
+#  define ssht_rw_entry_fetch_readers(entry, ids) rw_entry_ssht_fetch_readers(entry, ids)
+#else
+#  define ssht_rw_entry_has_readers(entry) (entry)->readers.nr
+#  define ssht_rw_entry_is_free(entry) ((entry)->readers.nr == 0 && (entry)->writer == SSHT_NO_WRITER)
+#  define ssht_rw_entry_has_other_readers(entry, id) reader_set_has_others(&(entry)->readers, id)
+#  define ssht_rw_entry_fetch_readers(entry, ids) reader_set_fetch(&(entry)->readers, ids)
+#endif	/* BIT_OPTS */
+
+/* whether node id is a reader or the writer of the entry. Single locks are
+   released without removing their log entries, thus a log entry is stale
+   if its node does not hold the entry (anymore) */
+#if defined(BIT_OPTS)
+#  define ssht_rw_entry_holds(entry, id) ((entry)->writer == (id) || rw_entry_ssht_is_member(entry, id))
+#else
+#  define ssht_rw_entry_holds(entry, id) ((entry)->writer == (id) || reader_set_is_member(&(entry)->readers, id))
+#endif	/* BIT_OPTS */
+
+/*
+ * The reader/writer conflict detection on the entry of an address, shared by
+ * the hashtables that keep ssht_rw_entry_t entries (ssht, oaht). slot points
+ * to the key of the entry (the one kept in the log). The contention manager
+ * might remove the defenders (and free the entry) before the attacker wins,
+ * thus the key is written back after a successful resolution.
+ */
+INLINED TM2C_CONFLICT_T
+ssht_rw_entry_insert_r(ssht_rw_entry_t* e, addr_t* slot, uintptr_t addr, ssht_log_set_t* log, uint32_t id)
+{
+  if (e->writer != SSHT_NO_WRITER) 
+    {
+#if !defined(NOCM) && !defined(BACKOFF_RETRY) 			/* if any other CM (greedy, wholly, faircm) */
+      if (!contention_manager_raw_waw(id, (uint16_t) e->writer, READ_AFTER_WRITE)) 
+	{
+	  return READ_AFTER_WRITE;
+	}
+#else
+      return READ_AFTER_WRITE;
+#endif	/* NOCM */
+    }
+
+  *slot = addr;
+#if defined(BIT_OPTS)
+  rw_entry_ssht_set(e, id);
+  ssht_log_set_insert(log, slot, e);
+#else
+  if (reader_set_insert(&e->readers, id))
+    {
+      ssht_log_set_insert(log, slot, e);
+    }
+#endif	/* BIT_OPTS */
+
+  return NO_CONFLICT;
+}
+
+/* static: with the readers array for the CM, it is not always inlined and
+   INLINED has no external definition */
+static inline TM2C_CONFLICT_T
+ssht_rw_entry_insert_w(ssht_rw_entry_t* e, addr_t* slot, uintptr_t addr, ssht_log_set_t* log, uint32_t id)
+{
+  if (e->writer == id)		/* already locked and logged */
+    {
+      return NO_CONFLICT;
+    }
 
-#define ssht_rw_entry_has_readers(entry) (entry)->nr
+  if (e->writer != SSHT_NO_WRITER) /* there is a writer for this entry */
+    {
+#if !defined(NOCM) && !defined(BACKOFF_RETRY)                    /* any other CM (greedy, wholly, faircm) */
+      if (!contention_manager_raw_waw(id, e->writer, WRITE_AFTER_WRITE)) 
+	{
+	  return WRITE_AFTER_WRITE;
+	}
+#else   /* NOCM */
+      return WRITE_AFTER_WRITE;
+#endif	/* NOCM */
+    }
+  else if (ssht_rw_entry_has_other_readers(e, id))
+    {
+#if !defined(NOCM) && !defined(BACKOFF_RETRY) 			/* if any other CM (greedy, wholly, faircm) */
+      nodeid_t readers[MAX_READERS];
+      uint32_t num_readers = ssht_rw_entry_fetch_readers(e, readers);
 
-INLINED TM2C_CONFLICT_T 
+      if (!contention_manager_war(id, readers, num_readers, WRITE_AFTER_READ))
+	{
+	  return WRITE_AFTER_READ;
+	}
+#else
+      return WRITE_AFTER_READ;
+#endif	/* NOCM */
+    }
+
+  /* no other reader or writer */
+  *slot = addr;
+  e->writer = id;
+  ssht_log_set_insert(log, slot, e);
+  return NO_CONFLICT;
+}
+
+/* removes node id from the entry. Returns TRUE if the entry is now free */
+INLINED uint32_t
+ssht_rw_entry_remove(ssht_rw_entry_t* entry, uint32_t id)
+{
+  if (entry->writer == id) 
+    {
+      entry->writer = SSHT_NO_WRITER;
+    }
+#if defined(BIT_OPTS)
+  else 
+    {
+      rw_entry_ssht_unset(entry, id);
+    }
+#else
+  else
+    {
+      reader_set_remove(&entry->readers, id);
+    }
+#endif	/* BIT_OPTS */
+
+  return ssht_rw_entry_is_free(entry);
+}
+
+/* removes node id as a reader or as the writer (rw) from the entry. Returns
+   TRUE if the entry is now free */
+INLINED uint32_t
+ssht_rw_entry_remove_rw(ssht_rw_entry_t* entry, uint32_t id, RW rw)
+{
+  if (rw == WRITE) 
+    {
+      if (entry->writer == id)
+	{
+	  entry->writer = SSHT_NO_WRITER;
+	}
+    }
+#if defined(BIT_OPTS)
+  else 
+    {
+      rw_entry_ssht_unset(entry, id);
+    }
+#else
+  else
+    {
+      reader_set_remove(&entry->readers, id);
+    }
+#endif	/* BIT_OPTS */
+
+  return ssht_rw_entry_is_free(entry);
+}
+
+/* the write lock of node id on the entry becomes a read lock. The log entry
+   of the write lock is kept for the read one */
+INLINED void
+ssht_rw_entry_downgrade(ssht_rw_entry_t* entry, uint32_t id)
+{
+#if defined(BIT_OPTS)
+  rw_entry_ssht_set(entry, id);
+#else
+  reader_set_insert(&entry->readers, id);
+#endif	/* BIT_OPTS */
+  entry->writer = SSHT_NO_WRITER;
+}
+
+INLINED TM2C_CONFLICT_T
 ssht_insert(ssht_hashtable_t ht, uint32_t bu, ssht_log_set_t* log, uint32_t id, uintptr_t addr, RW rw) 
 {
 #if defined(SSHT_DBG_UTILIZATION)
@@ -163,38 +347,11 @@ ssht_insert(ssht_hashtable_t ht, uint32_t bu, ssht_log_set_t* log, uint32_t id,
 INLINED uint32_t 
 ssht_bucket_remove_index(addr_t *addr, uint32_t id, ssht_rw_entry_t *entry) 
 {
-#if defined(BIT_OPTS)
-  if (entry->writer == id) 
-    {
-      entry->writer = SSHT_NO_WRITER;
-    }
-  else 
-    {
-      rw_entry_ssht_unset(entry, id);
-    }
-    
-  if (rw_entry_ssht_is_empty(entry))
-    {
-      *addr = 0;
-    }
-
-#else
-  if (entry->writer == id) 
-    {
-      entry->writer = SSHT_NO_WRITER;
-    }
-  else 
-    {
-      entry->reader[id] = 0;
-      entry->nr--;
-    }
-    
-  if (entry->nr == 0 && entry->writer == SSHT_NO_WRITER) 
+  if (ssht_rw_entry_remove(entry, id))
     {
       *addr = 0;
+      ssht_bucket_of(entry)->tag[entry->idx] = 0;
     }
-
-#endif	/* BIT_OPTS */
   return TRUE;
 }
 
@@ -204,50 +361,16 @@ ssht_remove_any(addr_t *addr, uint32_t id, ssht_rw_entry_t *entry)
   return ssht_bucket_remove_index(addr, id, entry);
 }
 
+/* releases rw of node id on the entry (found with bucket_lookup). The log
+   entry of the node is left behind (see ssht_rw_entry_holds) */
 INLINED void 
-ssht_remove(ssht_log_set_t* log, uint32_t id, addr_t* addr, RW rw) 
+ssht_remove(uint32_t id, ssht_rw_entry_t* entry, RW rw) 
 {
-  ssht_log_entry_t *entries = log->log_entries;
-  uint32_t j;
-  for (j = 0; j < log->nb_entries; j++) 
+  if (ssht_rw_entry_remove_rw(entry, id, rw))
     {
-      if (entries[j].address != NULL && *entries[j].address == (uintptr_t) addr)
-	{
-	  ssht_rw_entry_t* entry = entries[j].entry;
-	  if (rw == WRITE) 
-	    {
-	      if (entry->writer == id)
-		{
-		  entry->writer = SSHT_NO_WRITER;
-		}
-	    }
-
-#if defined(BIT_OPTS)
-	  else 
-	    {
-	      rw_entry_ssht_unset(entry, id);
-	    }
-    
-#else
-	  else 
-	    {
-	      entry->reader[id] = 0;
-	      entry->nr--;
-	    }
-    
-	  /* WHY not?? */
-	  /* if (entry->nr == 0 && entry->writer == SSHT_NO_WRITER)  */
-	  /*   { */
-	  /*     *addr = 0; */
-	  /*   } */
-#endif	/* BIT_OPTS */
-
-	  /* entries[j].address = NULL; */
-	  int last = --log->nb_entries;
-	  entries[j].address = entries[last].address;
-	  entries[j].entry = entries[last].entry;
-	  break;
-	}
+      bucket_t* bu = ssht_bucket_of(entry);
+      bu->addr[entry->idx] = 0;
+      bu->tag[entry->idx] = 0;
     }
 }
 
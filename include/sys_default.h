@@ -77,6 +77,7 @@ INLINED int
 sys_sendcmd(void* data, size_t len, nodeid_t to)
 {
   ssmp_send(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -90,6 +91,7 @@ INLINED int
 sys_sendcmd_no_sync(void* data, size_t len, nodeid_t to)
 {
   ssmp_send_no_sync(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -100,6 +102,7 @@ sys_sendcmd_all(void* data, size_t len)
   for (target = 0; target < NUM_DSL_NODES; target++) {
     ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
   }
+  TM2C_STATS_SENT(NUM_DSL_NODES);
   return 1;
 }
 
@@ -107,6 +110,7 @@ INLINED int
 sys_recvcmd(void* data, size_t len, nodeid_t from)
 {
   ssmp_recv_from(from, (ssmp_msg_t *) data);
+  TM2C_STATS_RECV(1);
   return 1;
 }
 
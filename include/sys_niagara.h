@@ -78,6 +78,7 @@ INLINED int
 sys_sendcmd(void* data, size_t len, nodeid_t to)
 {
   ssmp_send(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -91,6 +92,7 @@ INLINED int
 sys_sendcmd_no_sync(void* data, size_t len, nodeid_t to)
 {
   ssmp_send_no_sync(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -111,6 +113,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
 
       tm2c_rpc_stats_send.stats_type = 1;
@@ -118,6 +121,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
 
       tm2c_rpc_stats_send.stats_type = 2;
@@ -125,6 +129,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
 
       tm2c_rpc_stats_send.stats_type = 3;
@@ -132,6 +137,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
     }
   else
@@ -142,6 +148,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
 
       tm2c_rpc_stats_send.stats_type = 5;
@@ -149,6 +156,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
 
       tm2c_rpc_stats_send.stats_type = 6;
@@ -156,6 +164,7 @@ sys_sendcmd_all(void* data, size_t len)
       for (target = 0; target < NUM_DSL_NODES; target++) 
 	{
 	  ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
+	  TM2C_STATS_SENT(1);
 	}
     }
   return 1;
@@ -165,6 +174,7 @@ INLINED int
 sys_recvcmd(void* data, size_t len, nodeid_t from)
 {
   ssmp_recv_from(from, (ssmp_msg_t *) data);
+  TM2C_STATS_RECV(1);
   return 1;
 }
 
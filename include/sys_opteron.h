@@ -78,6 +78,7 @@ INLINED int
 sys_sendcmd(void* data, size_t len, nodeid_t to)
 {
   ssmp_send(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -91,6 +92,7 @@ INLINED int
 sys_sendcmd_no_sync(void* data, size_t len, nodeid_t to)
 {
   ssmp_send_no_sync(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -102,6 +104,7 @@ sys_sendcmd_all(void* data, size_t len)
     {
       ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
     }
+  TM2C_STATS_SENT(NUM_DSL_NODES);
   return 1;
 }
 
@@ -113,6 +116,7 @@ sys_recvcmd(void* data, size_t len, nodeid_t from)
   /* uint32_t hops = get_num_hops(NODE_ID(), from); */
   /* wait_cycles(wait_after_send[hops]); */
   ssmp_recv_from(from, (ssmp_msg_t *) data);
+  TM2C_STATS_RECV(1);
   return 1;
 }
 
@@ -97,6 +97,7 @@ extern void* pgas_app_addr_from_offs(size_t offs);
   sys_sendcmd(void* data, size_t len, nodeid_t to)
   {
     ssmp_send(to, (ssmp_msg_t *) data);
+    TM2C_STATS_SENT(1);
     return 1;
   }
 
@@ -108,6 +109,7 @@ extern void* pgas_app_addr_from_offs(size_t offs);
       {
 	ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
       }
+    TM2C_STATS_SENT(NUM_DSL_NODES);
     return 1;
   }
 
@@ -115,6 +117,7 @@ extern void* pgas_app_addr_from_offs(size_t offs);
   sys_recvcmd(void* data, size_t len, nodeid_t from)
   {
     ssmp_recv_from(from, (ssmp_msg_t *) data, 8);
+    TM2C_STATS_RECV(1);
     return 1;
   }
 
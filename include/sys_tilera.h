@@ -115,6 +115,7 @@ extern "C" {
     tmc_udn_send_buffer(udn_header[to], UDN0_DEMUX_TAG, data, TM2C_RPC_REQ_SIZE_WORDS);
     /* tmc_udn_send_buffer(udn_header[to], UDN0_DEMUX_TAG, data, len/sizeof(int_reg_t)); */
     /* tmc_udn_send_buffer(udn_header[to], demux_tags[to], data, len/sizeof(int_reg_t)); */
+    TM2C_STATS_SENT(1);
     return 1;
   }
 
@@ -142,6 +143,7 @@ extern "C" {
 	/* nodeid_t dsl_id = dsl_nodes[target]; */
 	/* tmc_udn_send_buffer(udn_header[dsl_id], demux_tags[dsl_id], data, len/sizeof(int_reg_t)); */
       }
+    TM2C_STATS_SENT(NUM_DSL_NODES);
     return 1;
   
   }
@@ -166,6 +168,7 @@ extern "C" {
     /* 	tmc_udn3_receive_buffer(data, len/sizeof(int_reg_t)); */
     /* 	break; */
     /*   } */
+    TM2C_STATS_RECV(1);
     return 1;
   }
 
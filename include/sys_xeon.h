@@ -79,6 +79,7 @@ INLINED int
 sys_sendcmd(void* data, size_t len, nodeid_t to)
 {
   ssmp_send(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -92,6 +93,7 @@ INLINED int
 sys_sendcmd_no_sync(void* data, size_t len, nodeid_t to)
 {
   ssmp_send_no_sync(to, (ssmp_msg_t *) data);
+  TM2C_STATS_SENT(1);
   return 1;
 }
 
@@ -103,6 +105,7 @@ sys_sendcmd_all(void* data, size_t len)
     {
       ssmp_send(dsl_nodes[target], (ssmp_msg_t *) data);
     }
+  TM2C_STATS_SENT(NUM_DSL_NODES);
   return 1;
 }
 
@@ -110,6 +113,7 @@ INLINED int
 sys_recvcmd(void* data, size_t len, nodeid_t from)
 {
   ssmp_recv_from(from, (ssmp_msg_t *) data);
+  TM2C_STATS_RECV(1);
   return 1;
 }
 
@@ -0,0 +1,109 @@
+/*
+ *   File: tag_probe.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: compare a group of 1-byte tags at once (SSE2 / AVX2 / SWAR)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * tag_probe(tags, tag, &empty) loads TAG_PROBE_WIDTH tags and returns the
+ * bitmask of the ones equal to tag; empty gets the bitmask of the 0 (free)
+ * ones. The implementation is selected at compile time: AVX2, SSE2, or a
+ * portable SWAR one on 64-bit words (also with TAG_PROBE_SCALAR).
+ */
+
+#ifndef _TAG_PROBE_H_
+#define _TAG_PROBE_H_
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "common.h"
+
+#if defined(__AVX2__) && !defined(TAG_PROBE_SCALAR)
+#  include <immintrin.h>
+#  define TAG_PROBE_AVX2
+#  define TAG_PROBE_WIDTH 32
+#elif defined(__SSE2__) && !defined(TAG_PROBE_SCALAR)
+#  include <emmintrin.h>
+#  define TAG_PROBE_SSE2
+#  define TAG_PROBE_WIDTH 16
+#else
+#  define TAG_PROBE_SWAR
+#  define TAG_PROBE_WIDTH 8
+#endif
+
+/* the index of the lowest set bit of a (non-zero) mask */
+#define tag_probe_first(mask) __builtin_ctz(mask)
+
+#if defined(TAG_PROBE_AVX2)
+
+INLINED uint32_t
+tag_probe(const uint8_t* tags, uint8_t tag, uint32_t* empty)
+{
+  __m256i v = _mm256_loadu_si256((const __m256i*) tags);
+  *empty = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+  return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char) tag)));
+}
+
+#elif defined(TAG_PROBE_SSE2)
+
+INLINED uint32_t
+tag_probe(const uint8_t* tags, uint8_t tag, uint32_t* empty)
+{
+  __m128i v = _mm_loadu_si128((const __m128i*) tags);
+  *empty = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+  return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char) tag)));
+}
+
+#else  /* TAG_PROBE_SWAR */
+
+#define TAG_PROBE_LO7 0x7F7F7F7F7F7F7F7FULL
+
+/* 0x80 in every byte of x that is 0 (exact, no borrow between bytes) */
+INLINED uint64_t
+tag_probe_zero_bytes(uint64_t x)
+{
+  uint64_t y = (x & TAG_PROBE_LO7) + TAG_PROBE_LO7;
+  return ~(y | x | TAG_PROBE_LO7);
+}
+
+/* gathers the 0x80 bits of the bytes to the low 8 bits (byte i -> bit i) */
+INLINED uint32_t
+tag_probe_movemask(uint64_t x)
+{
+  return (uint32_t) (((x >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+INLINED uint32_t
+tag_probe(const uint8_t* tags, uint8_t tag, uint32_t* empty)
+{
+  uint64_t v;
+  memcpy(&v, tags, sizeof(v));
+#  if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);	/* tags[0] in the low byte */
+#  endif
+  *empty = tag_probe_movemask(tag_probe_zero_bytes(v));
+  return tag_probe_movemask(tag_probe_zero_bytes(v ^ (tag * 0x0101010101010101ULL)));
+}
+
+#endif	/* TAG_PROBE_AVX2 */
+
+#endif	/* _TAG_PROBE_H_ */
@@ -43,6 +43,14 @@
 #ifdef PGAS
 #  include "pgas_app.h"
 #endif
+#if defined(PGAS_MVCC)
+#  include "pgas_mvcc.h"
+#endif
+#include "dsl_dir.h"
+#include "tm2c_rmw.h"
+#include "tm2c_irrevoc.h"
+#include "tm2c_profile.h"
+#include "tm2c_histo.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -217,12 +225,147 @@ extern "C" {
 #  define WSET_PERSIST(tm2c_tx) write_set_persist(tm2c_tx)
 #endif
 
+#ifdef INVISIBLE_READS
+#  define RSET_VALIDATE()        tm2c_rpc_validate_all()
+#else
+#  define RSET_VALIDATE()
+#endif
+
+#if defined(PGAS_MVCC)
+#  define MVCC_SNAPSHOT_RESET()  tm2c_tx->snapshot = 0;
+#  define MVCC_COMMIT_START()    if (!tm2c_tx->snapshot) { pgas_mvcc_commit_start(); }
+#  define MVCC_COMMIT_END()      pgas_mvcc_commit_end();
+#else
+#  define MVCC_SNAPSHOT_RESET()
+#  define MVCC_COMMIT_START()
+#  define MVCC_COMMIT_END()
+#endif
+
+#if (ADDR_TO_DSL_SEL == 2)
+#  define DSL_DIR_TX_START()     dsl_dir_tx_start();
+#  define DSL_DIR_TX_END()       dsl_dir_tx_end();
+  /* a non-transactional RPC, unless within a transaction (already counted) */
+#  define DSL_DIR_NONTX_START()					\
+  uint32_t dsl_dir_nontx = !dsl_dir->app[NODE_ID()].in_tx;		\
+  if (dsl_dir_nontx)							\
+    {									\
+      dsl_dir_tx_start();						\
+    }
+#  define DSL_DIR_NONTX_END()			\
+  if (dsl_dir_nontx)				\
+    {						\
+      dsl_dir_tx_end();				\
+    }
+#else
+#  define DSL_DIR_TX_START()
+#  define DSL_DIR_TX_END()
+#  define DSL_DIR_NONTX_START()
+#  define DSL_DIR_NONTX_END()
+#endif
+
+#if defined(IRREVOCABLE)
+  /* on a restart after IRREVOCABLE_RETRIES tries; kept until the commit */
+#  define IRREVOC_ON_START()					\
+  if (tm2c_tx->retries > IRREVOCABLE_RETRIES && !tm2c_tx->irrevocable) \
+    {								\
+      tm2c_rpc_irrevoc();					\
+      tm2c_tx->irrevocable = 1;					\
+    }
+#  define IRREVOC_ON_COMMIT()			\
+  if (tm2c_tx->irrevocable)			\
+    {						\
+      tm2c_rpc_irrevoc_rls();			\
+      tm2c_tx->irrevocable = 0;			\
+    }
+#else
+#  define IRREVOC_ON_START()
+#  define IRREVOC_ON_COMMIT()
+#endif
+
+#if defined(TX_PROFILE)
+  /* the site to which the aborts of the tx are attributed */
+#  define TX_PROFILE_START()			\
+  tm2c_tx->site_file = __FILE__;		\
+  tm2c_tx->site_line = __LINE__;
+#else
+#  define TX_PROFILE_START()
+#endif
+
+#if defined(TX_HISTO)
+  /* the latency of the tx (with the retries), of the commit, and of its
+     phases: locking and validation, write-back, and release */
+#  define TX_HISTO_START()			\
+  tm2c_tx->histo_start = getticks();
+#  define TX_HISTO_COMMIT_START()		\
+  ticks histo_commit = getticks();		\
+  ticks histo_phase = histo_commit;
+#  define TX_HISTO_COMMIT_PHASE(histo)		\
+  {						\
+    ticks histo_now = getticks();		\
+    tm2c_histo_add(histo, histo_now - histo_phase);	\
+    histo_phase = histo_now;			\
+  }
+#  define TX_HISTO_COMMIT_END()					\
+  {								\
+    ticks histo_end = getticks();				\
+    tm2c_histo_add(TM2C_HISTO_COMMIT, histo_end - histo_commit);	\
+    tm2c_histo_add(TM2C_HISTO_TX, histo_end - tm2c_tx->histo_start);	\
+  }
+#else
+#  define TX_HISTO_START()
+#  define TX_HISTO_COMMIT_START()
+#  define TX_HISTO_COMMIT_PHASE(histo)
+#  define TX_HISTO_COMMIT_END()
+#endif
+
+  /*
+   * Closed nesting: a TX_START within a transaction starts a nested block,
+   * whose TX_COMMIT only ends it (the outermost one commits). A nested
+   * block saves the state of the tx at its start (up to TX_NESTING_MAX
+   * deep, the deeper ones are flattened). If it conflicts on DSL nodes that
+   * the enclosing blocks had not contacted (thus their locks are intact),
+   * only the block is rolled back and retried, up to TX_NESTING_RETRIES
+   * times. With PGAS the writes are buffered at the DSL nodes, thus the
+   * nesting is flat: any abort restarts the outermost block.
+   */
+#if defined(TX_NESTING)
+#  if defined(PGAS)
+#    define TX_SAVEPOINT()
+#  else
+#    define TX_SAVEPOINT()					\
+  if (tm2c_tx->nesting <= TX_NESTING_MAX + 1)			\
+    {								\
+      sigsetjmp(tm2c_tx_savepoint()->env, 0);			\
+    }
+#  endif
+#  define TX_NESTED_START()			\
+  if (tm2c_tx->nesting++ > 0)			\
+    {						\
+      TX_SAVEPOINT();				\
+    }						\
+  else
+#  define TX_NESTED_COMMIT()   if (--tm2c_tx->nesting == 0)
+#  define TX_NESTING_RESET()   tm2c_tx->nesting = 1;
+#  if defined(PGAS)
+#    define TX_ROLLBACK(reason)
+#  else
+#    define TX_ROLLBACK(reason) tm2c_tx_rollback(reason);
+#  endif
+#else
+#  define TX_NESTED_START()
+#  define TX_NESTED_COMMIT()
+#  define TX_NESTING_RESET()
+#  define TX_ROLLBACK(reason)
+#endif	/* TX_NESTING */
+
 #ifdef EAGER_WRITE_ACQ
 #  define WLOCKS_ACQUIRE()
 #  define WLOCK_ACQUIRE(addr)    tx_wlock(addr, 0)
+#  define WLOCK_ACQUIRE_ENTRY(we) tx_wlock_entry(we)
 #else
 #  define WLOCKS_ACQUIRE()       tm2c_rpc_store_all()
 #  define WLOCK_ACQUIRE(addr)
+#  define WLOCK_ACQUIRE_ENTRY(we)
 #endif
 
   /* -------------------------------------------------------------------------------- */
@@ -230,12 +373,12 @@ extern "C" {
   /* -------------------------------------------------------------------------------- */
 
 #if !defined(NOCM) && !defined(BACKOFF_RETRY) /* if any other CM (greedy, wholly, faircm) */
-#  define TXRUNNING()       set_tx_running();
-
 #  if defined(PGAS)
+#    define TXRUNNING()     set_tx_running();
 #    define TXCOMMITTED()   
 #    define TXCOMPLETED()   set_tx_committed();
 #  else	/* !PGAS */
+#    define TXRUNNING()     set_tx_running();
 #    define TXCOMMITTED()   set_tx_committed();
 #    define TXCOMPLETED()   
 #  endif	/* PGAS */
@@ -275,6 +418,10 @@ extern "C" {
 #    define CM_METADATA_INIT_ON_FIRST_START      tm2c_tx->start_ts = getticks();
 #  endif
 #  define CM_METADATA_UPDATE_ON_COMMIT         ;
+#elif defined(DYNAMIC_CM)
+#  define CM_METADATA_INIT_ON_START            tm2c_cm->on_start();
+#  define CM_METADATA_INIT_ON_FIRST_START      tm2c_cm->on_first_start();
+#  define CM_METADATA_UPDATE_ON_COMMIT         tm2c_cm->on_commit();
 #else  /* no cm defined */
 #  define CM_METADATA_INIT_ON_START            ;
 #  define CM_METADATA_INIT_ON_FIRST_START      ;
@@ -286,48 +433,97 @@ extern "C" {
 
 #define TX_START					\
   { PRINTD("|| Starting new tx");			\
+  TX_NESTED_START()					\
+  {							\
   CM_METADATA_INIT_ON_FIRST_START;			\
+  TX_PROFILE_START();					\
+  TX_HISTO_START();					\
+  DSL_DIR_TX_START();					\
   short int reason;					\
   if ((reason = sigsetjmp(tm2c_tx->env, 0)) != 0) {	\
     PRINTD("|| restarting due to %d", reason);		\
     WSET_EMPTY;						\
   }							\
+  TX_NESTING_RESET();					\
   tm2c_tx->retries++;					\
+  IRREVOC_ON_START();					\
   TXRUNNING();						\
-  CM_METADATA_INIT_ON_START;
+  CM_METADATA_INIT_ON_START;				\
+  MVCC_SNAPSHOT_RESET();				\
+  }
+
+  /*
+   * A read-only transaction. With PGAS_MVCC, it reads the snapshot of the
+   * start time without registering its reads at the DSL, thus it does not
+   * conflict with update transactions (it must not write)
+   */
+#if defined(PGAS_MVCC)
+#  define TX_START_RO					\
+  TX_START						\
+  tm2c_tx->snapshot = pgas_mvcc_snapshot();
+#else
+#  define TX_START_RO   TX_START
+#endif
 
 #define TX_ABORT(reason)			\
   PRINTD("|| aborting tx (%d)", reason);	\
+  TX_ROLLBACK(reason);				\
   tm2c_handle_abort(tm2c_tx, reason);		\
   siglongjmp(tm2c_tx->env, reason);
 
 #define TX_COMMIT				\
+  TX_NESTED_COMMIT()				\
+  {						\
+  TX_HISTO_COMMIT_START();			\
   WLOCKS_ACQUIRE();				\
+  RSET_VALIDATE();				\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_ACQ);	\
+  MVCC_COMMIT_START();				\
   TXPERSISTING();				\
   WSET_PERSIST(tm2c_tx->write_set);		\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_PERSIST);	\
   TXCOMMITTED();				\
   tm2c_rpc_rls_all(NO_CONFLICT);		\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_RLS);	\
+  IRREVOC_ON_COMMIT();				\
+  MVCC_COMMIT_END();				\
+  DSL_DIR_TX_END();				\
   TXCOMPLETED();				\
   CM_METADATA_UPDATE_ON_COMMIT;			\
+  TX_HISTO_COMMIT_END();			\
   tm2c_tx_node->tx_starts++;			\
   tm2c_tx_node->tx_committed++;			\
   tm2c_tx_node->tx_aborted += tm2c_tx->aborts;	\
-  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);}
+  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);	\
+  }}
 
 
 #define TX_COMMIT_MEM				\
+  TX_NESTED_COMMIT()				\
+  {						\
+  TX_HISTO_COMMIT_START();			\
   WLOCKS_ACQUIRE();				\
+  RSET_VALIDATE();				\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_ACQ);	\
+  MVCC_COMMIT_START();				\
   TXPERSISTING();				\
   WSET_PERSIST(tm2c_tx->write_set);		\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_PERSIST);	\
   TXCOMMITTED();				\
   tm2c_rpc_rls_all(NO_CONFLICT);		\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_RLS);	\
+  IRREVOC_ON_COMMIT();				\
+  MVCC_COMMIT_END();				\
+  DSL_DIR_TX_END();				\
   TXCOMPLETED();				\
   CM_METADATA_UPDATE_ON_COMMIT;			\
+  TX_HISTO_COMMIT_END();			\
   mem_info_on_commit(tm2c_tx->mem_info);	\
   tm2c_tx_node->tx_starts++;			\
   tm2c_tx_node->tx_committed++;			\
   tm2c_tx_node->tx_aborted += tm2c_tx->aborts;	\
-  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);}
+  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);	\
+  }}
 
 
   /* #define TX_COMMIT					\ */
@@ -341,38 +537,67 @@ extern "C" {
 
 
 #define TX_COMMIT_NO_STATS			\
+  TX_NESTED_COMMIT()				\
+  {						\
   WLOCKS_ACQUIRE();				\
+  RSET_VALIDATE();				\
+  MVCC_COMMIT_START();				\
   TXPERSISTING();				\
   WSET_PERSIST(tm2c_tx->write_set);		\
   TXCOMMITTED();				\
   tm2c_rpc_rls_all(NO_CONFLICT);		\
+  IRREVOC_ON_COMMIT();				\
+  MVCC_COMMIT_END();				\
+  DSL_DIR_TX_END();				\
   TXCOMPLETED();				\
   CM_METADATA_UPDATE_ON_COMMIT;			\
   mem_info_on_commit(tm2c_tx->mem_info);	\
   tm2c_tx_node->tx_committed++;			\
-  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);}
+  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);	\
+  }}
 
 #define TX_COMMIT_NO_PUB_NO_STATS		\
+  TX_NESTED_COMMIT()				\
+  {						\
+  RSET_VALIDATE();				\
+  MVCC_COMMIT_START();				\
   TXPERSISTING();				\
   WSET_PERSIST(tm2c_tx->write_set);		\
   TXCOMMITTED();				\
   tm2c_rpc_rls_all(NO_CONFLICT);		\
+  IRREVOC_ON_COMMIT();				\
+  MVCC_COMMIT_END();				\
+  DSL_DIR_TX_END();				\
   TXCOMPLETED();				\
   CM_METADATA_UPDATE_ON_COMMIT;			\
   mem_info_on_commit(tm2c_tx->mem_info);	\
-  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);}
+  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);	\
+  }}
 
 #define TX_COMMIT_NO_PUB			\
+  TX_NESTED_COMMIT()				\
+  {						\
+  TX_HISTO_COMMIT_START();			\
+  RSET_VALIDATE();				\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_ACQ);	\
+  MVCC_COMMIT_START();				\
   TXPERSISTING();				\
   WSET_PERSIST(tm2c_tx->write_set);		\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_PERSIST);	\
   TXCOMMITTED();				\
   tm2c_rpc_rls_all(NO_CONFLICT);		\
+  TX_HISTO_COMMIT_PHASE(TM2C_HISTO_COMMIT_RLS);	\
+  IRREVOC_ON_COMMIT();				\
+  MVCC_COMMIT_END();				\
+  DSL_DIR_TX_END();				\
   TXCOMPLETED();				\
   CM_METADATA_UPDATE_ON_COMMIT;			\
+  TX_HISTO_COMMIT_END();			\
   tm2c_tx_node->tx_starts += tm2c_tx->retries;	\
   tm2c_tx_node->tx_committed++;			\
   tm2c_tx_node->tx_aborted += tm2c_tx->aborts;	\
-  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx); }
+  tm2c_tx = tm2c_tx_meta_empty(tm2c_tx);	\
+  }}
 
 
 #define TM_END					\
@@ -407,6 +632,37 @@ extern "C" {
 
 #define TX_LOAD_T(addr,type) (type)TX_LOAD(addr)
 
+  /*
+   * Read-lock all the words in [addr, addr + len) (non-PGAS). The words can
+   * then be read directly from memory; note that they do not reflect the
+   * writes that the transaction itself has buffered.
+   */
+#define TX_LOAD_RANGE(addr, len)		\
+  tx_load_range((tm_addr_t) (addr), len)
+
+  /*
+   * Split-phase loads: TX_LOAD_ASYNC sends the read-lock request and returns,
+   * so that requests to different DSL nodes can be in flight at the same time.
+   * TX_LOAD_WAIT returns what TX_LOAD would have returned for the address.
+   * TX_PREFETCH_RANGE read-locks num addresses, stride bytes apart, starting 
+   * at addr; the values are then obtained (w/o messages) with TX_LOAD_WAIT.
+   */
+#if defined(PGAS)
+#  define TX_LOAD_ASYNC(addr, words)				\
+  tx_load_async(WSET, (addr), words)
+#  define TX_LOAD_WAIT(addr, words)				\
+  tx_load_wait(WSET, (addr), words)
+#  define TX_PREFETCH_RANGE(addr, num, stride, words)		\
+  tx_prefetch_range(WSET, (tm_addr_t) (addr), num, stride, words)
+#else
+#  define TX_LOAD_ASYNC(addr)					\
+  tx_load_async(WSET, (addr), 0)
+#  define TX_LOAD_WAIT(addr)					\
+  tx_load_wait(WSET, (addr))
+#  define TX_PREFETCH_RANGE(addr, num, stride)			\
+  tx_prefetch_range(WSET, (tm_addr_t) (addr), num, stride, 0)
+#endif	/* PGAS */
+
   /*
    * addr is the local address
    * NONTX acts as a regular load on iRCCE w/o PGAS
@@ -441,11 +697,72 @@ extern "C" {
   } while (0)
 #endif
 
-#define TX_CAS(addr, oldval, newval)		\
-  tx_cas(addr, oldval, newval);
+  /*
+   * TX_STORE_BLOCK buffers len bytes from src as a single write-set entry
+   * (locked with one TM2C_RPC_STORE_MULTI per DSL node). In PGAS, it is one
+   * TX_STORE per 64-bit word, as the DSL nodes persist 64 bits per store:
+   * addr and len must be multiples of 8.
+   */
+#if defined(PGAS)
+#  define TX_STORE_BLOCK(addr, src, len)				\
+  do {									\
+    uint32_t w__;							\
+    assert((uintptr_t) (addr) % sizeof(int64_t) == 0			\
+	   && (len) % sizeof(int64_t) == 0);				\
+    for (w__ = 0; w__ < (uint32_t) (len); w__ += sizeof(int64_t))	\
+      {									\
+	TXCHKABORTED();							\
+	tx_wlock((tm_addr_t) ((uint8_t*) (addr) + w__),			\
+		 *(int64_t*) ((uint8_t*) (src) + w__));			\
+      }									\
+  } while (0)
+#else /* !PGAS */
+#  define TX_STORE_BLOCK(addr, src, len)				\
+  do {									\
+    TXCHKABORTED();							\
+    tm_intern_addr_t intern_addr = to_intern_addr((tm_addr_t) (addr));	\
+    write_entry_t* we__ = write_set_insert_block(tm2c_tx->write_set,	\
+						 (src), (len), intern_addr); \
+    WLOCK_ACQUIRE_ENTRY(we__);						\
+  } while (0)
+#endif	/* PGAS */
+
+  /*
+   * Read-modify-write operations (tm2c_rmw.h) on a TYPE_INT or TYPE_INT64
+   * word; they return the old value. TX_RMW write-locks the word and its new
+   * value joins the write set (with PGAS, it is computed by the DSL node).
+   * NONTX_RMW, outside transactions, is applied and committed at once by
+   * the DSL node with a single message (retried on conflicts).
+   * TX_CAS (pointer-sized words) and TX_CASI (TYPE_INT) swapped iff they
+   * return oldval; a failed one still write-locks the word.
+   */
+#define TX_RMW(addr, op, value, datatype)				\
+  tx_rmw(WSET, (tm_addr_t) (addr), TM2C_RMW_FOR(op, datatype), (value), 0)
+
+#define NONTX_RMW(addr, op, value, datatype)				\
+  nontx_rmw((tm_addr_t) (addr), TM2C_RMW_FOR(op, datatype), (value), 0)
+
+#define TX_FETCH_ADD(addr, value, datatype)	\
+  TX_RMW(addr, TM2C_RMW_ADD, value, datatype)
 
-#define TX_CASI(addr, oldval, newval)		\
-  tx_casi(addr, oldval, newval);
+#define NONTX_FETCH_ADD(addr, value, datatype)	\
+  NONTX_RMW(addr, TM2C_RMW_ADD, value, datatype)
+
+#define TX_CAS(addr, oldval, newval)					\
+  tx_rmw(WSET, (tm_addr_t) (addr), TM2C_RMW_FOR(TM2C_RMW_CAS, TYPE_PTR),	\
+	 (int64_t) (oldval), (int64_t) (newval))
+
+#define TX_CASI(addr, oldval, newval)					\
+  tx_rmw(WSET, (tm_addr_t) (addr), TM2C_RMW_FOR(TM2C_RMW_CAS, TYPE_INT),	\
+	 (oldval), (newval))
+
+#define NONTX_CAS(addr, oldval, newval)					\
+  nontx_rmw((tm_addr_t) (addr), TM2C_RMW_FOR(TM2C_RMW_CAS, TYPE_PTR),	\
+	    (int64_t) (oldval), (int64_t) (newval))
+
+#define NONTX_CASI(addr, oldval, newval)				\
+  nontx_rmw((tm_addr_t) (addr), TM2C_RMW_FOR(TM2C_RMW_CAS, TYPE_INT),	\
+	    (oldval), (newval))
 
 
 #if defined(PGAS)
@@ -461,12 +778,7 @@ extern "C" {
   do { tx_store_inc(addr, op(value)); } while (0)
 #else
 #  define TX_LOAD_STORE(addr, op, value, datatype)			\
-  do {									\
-    tx_wlock(addr, 0);							\
-    int temp__ = (*(int* ) (addr)) op (value);				\
-    tm_intern_addr_t intern_addr = to_intern_addr((tm_addr_t)addr);	\
-    write_set_insert(tm2c_tx->write_set, TYPE_INT, temp__, intern_addr); \
-  } while (0)
+  do { TX_RMW(addr, TM2C_RMW_ADD, op(value), datatype); } while (0)
 #endif
 
 #define DUMMY_MSG(to)				\
@@ -474,8 +786,32 @@ extern "C" {
   
 
 
-  /*early release of READ lock -- TODO: the entry remains in read-set, so one
-    SHOULD NOT try to re-read the address cause the tx things it keeps the lock*/
+  /*
+   * Early release, for elastic transactions (e.g., hand-over-hand traversals
+   * of a list): TX_RELEASE releases the read lock of the tx for addr (a write
+   * lock is kept until the commit). A later TX_LOAD of addr locks it again.
+   * The DSL node replies whether the tx still holds any lock on it, so that
+   * the commit/abort does not contact it if not.
+   *
+   * TX_DOWNGRADE turns the write lock of the tx for addr into a read lock:
+   * the buffered writes of addr are dropped (not the ones of TX_STORE_BLOCK
+   * entries, thus it must not be used for words of blocks).
+   *
+   * TX_RRLS is the unacknowledged TX_RELEASE: cheaper, but the DSL node of
+   * addr is always released at commit. TX_WRLS releases a write lock
+   * without persisting the write (used internally).
+   */
+#define TX_RELEASE(addr)			\
+  tm2c_rpc_release((tm_addr_t) (addr))
+
+#if defined(PGAS)
+#  define TX_DOWNGRADE(addr)			\
+  tm2c_rpc_downgrade((tm_addr_t) (addr))
+#else
+#  define TX_DOWNGRADE(addr)			\
+  tm2c_tx_downgrade((tm_addr_t) (addr))
+#endif	/* PGAS */
+
 #define TX_RRLS(addr)				\
   tm2c_rpc_load_rls((void*) (addr));
 
@@ -501,6 +837,35 @@ extern "C" {
 
   void tm2c_handle_abort(tm2c_tx_t* tm2c_tx, TM2C_CONFLICT_T reason);
 
+#if !defined(PGAS)
+  /* drops the buffered writes of addr and downgrades its write lock */
+  void tm2c_tx_downgrade(tm_addr_t addr);
+#endif	/* !PGAS */
+
+#if defined(TX_NESTING) && !defined(PGAS)
+  /* saves the state of the tx at the start of a nested block */
+  tm2c_tx_savepoint_t* tm2c_tx_savepoint();
+  /* rolls back and restarts the innermost nested block with a savepoint,
+     if the enclosing blocks are intact, else returns */
+  void tm2c_tx_rollback(TM2C_CONFLICT_T reason);
+
+  /* the write set entries that a rollback keeps */
+  INLINED uint32_t
+  tm2c_tx_ws_kept()
+  {
+    uint32_t depth = tm2c_tx->nesting;
+    if (depth < 2)
+      {
+	return 0;
+      }
+    if (depth > TX_NESTING_MAX + 1)
+      {
+	depth = TX_NESTING_MAX + 1;
+      }
+    return tm2c_tx->savepoints[depth - 2].ws_entries;
+  }
+#endif
+
   /*
    * API function
    * accepts the machine-local address, which must be translated to the appropriate
@@ -533,7 +898,7 @@ extern "C" {
     write_entry_t* we;
     if ((we = write_set_contains(ws, intern_addr)) != NULL) 
       {
-	return (void* ) &we->i;
+	return write_entry_value(ws, we, intern_addr);
       }
     else 
       {
@@ -549,6 +914,118 @@ extern "C" {
       }
   }
 #endif	/* PGAS */
+#if defined(PGAS)
+  INLINED void
+  tx_load_async(tm2c_write_set_pgas_t* ws, tm_addr_t addr, int words)
+#else
+  INLINED void
+  tx_load_async(tm2c_write_set_t* ws, tm_addr_t addr, int words)
+#endif	/* PGAS */
+  {
+    TM2C_CONFLICT_T conflict;
+#if !defined(PGAS)
+    if (write_set_contains(ws, to_intern_addr(addr)) != NULL)
+      {
+	return;
+      }
+#endif	/* !PGAS */
+    TXCHKABORTED();
+    if ((conflict = tm2c_rpc_load_async(addr, words)) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+  }
+
+#if defined(PGAS)
+  INLINED int64_t
+  tx_load_wait(tm2c_write_set_pgas_t* ws, tm_addr_t addr, int words)
+  {
+    TM2C_CONFLICT_T conflict;
+    if ((conflict = tm2c_rpc_load_wait(addr, words)) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+    return read_value;
+  }
+#else  /* !PGAS */
+  INLINED tm_addr_t 
+  tx_load_wait(tm2c_write_set_t* ws, tm_addr_t addr)
+  {
+    tm_intern_addr_t intern_addr = to_intern_addr(addr);
+    write_entry_t* we;
+    if ((we = write_set_contains(ws, intern_addr)) != NULL) 
+      {
+	return write_entry_value(ws, we, intern_addr);
+      }
+
+    TM2C_CONFLICT_T conflict;
+    if ((conflict = tm2c_rpc_load_wait(addr, 0)) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+    return addr;
+  }
+#endif	/* PGAS */
+
+#if defined(PGAS)
+  INLINED void
+  tx_prefetch_range(tm2c_write_set_pgas_t* ws, tm_addr_t addr, uint32_t num, size_t stride, int words)
+#else
+  INLINED void
+  tx_prefetch_range(tm2c_write_set_t* ws, tm_addr_t addr, uint32_t num, size_t stride, int words)
+#endif	/* PGAS */
+  {
+    TM2C_CONFLICT_T conflict;
+    uint32_t i;
+    for (i = 0; i < num; i++)
+      {
+	tx_load_async(ws, (tm_addr_t) ((uintptr_t) addr + i * stride), words);
+      }
+
+    if ((conflict = tm2c_rpc_load_drain_all()) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+  }
+
+#if !defined(PGAS)
+  INLINED void
+  tx_load_range(tm_addr_t addr, size_t len)
+  {
+    TM2C_CONFLICT_T conflict;
+    TXCHKABORTED();
+#  if defined(TM2C_RANGE_LOCKS)
+    if ((conflict = tm2c_rpc_load_range(addr, len)) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+#  else
+    uintptr_t a;
+    for (a = (uintptr_t) addr; a < (uintptr_t) addr + len; a += sizeof(int32_t))
+      {
+	if ((conflict = tm2c_rpc_load((tm_addr_t) a, 0)) != NO_CONFLICT)
+	  {
+	    TX_ABORT(conflict);
+	  }
+      }
+#  endif	/* TM2C_RANGE_LOCKS */
+  }
+#endif	/* !PGAS */
+
+#if !defined(PGAS)
+  /* write-lock all the words of the write-set entry we */
+  INLINED void
+  tx_wlock_entry(write_entry_t* we)
+  {
+    TM2C_CONFLICT_T conflict;
+    TXCHKABORTED();
+    if ((conflict = tm2c_rpc_store_multi(we, 1)) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+  }
+#endif	/* !PGAS */
+
   /*  get a tx write lock for address addr
    */
   INLINED
@@ -602,6 +1079,101 @@ extern "C" {
   }
 #endif  /* PGAS */
 
+  /*
+   * The read-modify-write operation rmw on addr, within a transaction
+   */
+#if defined(PGAS)
+  INLINED int64_t
+  tx_rmw(tm2c_write_set_pgas_t* ws, tm_addr_t addr, uint32_t rmw, int64_t arg, int64_t arg2)
+  {
+#  if defined(TM2C_RPC_HAS_RMW)
+    TM2C_CONFLICT_T conflict;
+    TXCHKABORTED();
+    if ((conflict = tm2c_rpc_rmw(addr, rmw, arg, arg2)) != NO_CONFLICT)
+      {
+	TX_ABORT(conflict);
+      }
+    return read_value;
+#  else	 /* no room for the operation in the messages: the word must not
+	    have been written by the transaction (a load would conflict) */
+    int64_t old = tx_load(ws, addr, (rmw & TM2C_RMW_64) ? 2 : 1);
+    tx_wlock(addr, tm2c_rmw_apply(rmw, old, arg, arg2));
+    return old;
+#  endif	/* TM2C_RPC_HAS_RMW */
+  }
+#else  /* !PGAS */
+  INLINED int64_t
+  tx_rmw(tm2c_write_set_t* ws, tm_addr_t addr, uint32_t rmw, int64_t arg, int64_t arg2)
+  {
+    tm_intern_addr_t intern_addr = to_intern_addr(addr);
+    int64_t old;
+    write_entry_t* we;
+    if ((we = write_set_contains(ws, intern_addr)) != NULL)
+      {
+	void* val = write_entry_value(ws, we, intern_addr);
+	uint32_t size = (rmw & TM2C_RMW_64) ? sizeof(int64_t) : sizeof(int32_t);
+	if (intern_addr - we->address + size > WRITE_ENTRY_SIZE(we))
+	  {
+	    /* the entry is narrower than the operation: the new value gets its
+	       own entry, of the width of the operation, and the upper word of
+	       a 64-bit one is loaded and written as usual */
+	    int64_t cur = 0;
+	    memcpy(&cur, val, sizeof(int32_t));
+	    if (rmw & TM2C_RMW_64)
+	      {
+		tm_addr_t upper = (tm_addr_t) ((uint8_t*) addr + sizeof(int32_t));
+		memcpy((uint8_t*) &cur + sizeof(int32_t), tx_load(ws, upper), sizeof(int32_t));
+		WLOCK_ACQUIRE(upper);
+	      }
+	    old = tm2c_rmw_load(&cur, rmw);
+	    write_set_insert(ws, (rmw & TM2C_RMW_64) ? TYPE_INT64 : TYPE_INT,
+			     tm2c_rmw_apply(rmw, old, arg, arg2), intern_addr);
+	    return old;
+	  }
+	old = tm2c_rmw_load(val, rmw);
+#if defined(TX_NESTING)
+	/* an entry of the enclosing blocks is kept for a rollback */
+	if (we < ws->write_entries + tm2c_tx_ws_kept())
+	  {
+	    write_set_insert(ws, (rmw & TM2C_RMW_64) ? TYPE_INT64 : TYPE_INT,
+			     tm2c_rmw_apply(rmw, old, arg, arg2), intern_addr);
+	    return old;
+	  }
+#endif
+	tm2c_rmw_store(val, rmw, tm2c_rmw_apply(rmw, old, arg, arg2));
+	return old;
+      }
+
+    /* the memory is not written while the lock is held (on both words of a
+       64-bit operation) */
+    tx_wlock(addr, 0);
+    if (rmw & TM2C_RMW_64)
+      {
+	tx_wlock((tm_addr_t) ((uint8_t*) addr + sizeof(int32_t)), 0);
+      }
+    old = tm2c_rmw_load(addr, rmw);
+    write_set_insert(ws, (rmw & TM2C_RMW_64) ? TYPE_INT64 : TYPE_INT,
+		     tm2c_rmw_apply(rmw, old, arg, arg2), intern_addr);
+    return old;
+  }
+#endif	/* PGAS */
+
+  /*
+   * The read-modify-write operation rmw on addr, outside transactions
+   */
+#if defined(TM2C_RPC_HAS_RMW)
+  INLINED int64_t
+  nontx_rmw(tm_addr_t addr, uint32_t rmw, int64_t arg, int64_t arg2)
+  {
+    return tm2c_rpc_notx_rmw(addr, rmw, arg, arg2);
+  }
+#else
+  /* a transaction of a single tx_rmw (tm2c.c) */
+  extern int64_t tm2c_nontx_rmw_tx(tm_addr_t addr, uint32_t rmw, int64_t arg, int64_t arg2);
+#  define nontx_rmw(addr, rmw, arg, arg2)	\
+  tm2c_nontx_rmw_tx(addr, rmw, arg, arg2)
+#endif	/* TM2C_RPC_HAS_RMW */
+
 
   extern void tm2c_init_system(int* argc, char** argv[]);
   extern void tm2c_init(void);
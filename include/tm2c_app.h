@@ -53,6 +53,27 @@ extern "C" {
    */
   TM2C_CONFLICT_T tm2c_rpc_load(tm_addr_t address, int words);
 
+#if defined(TM2C_RANGE_LOCKS)
+  /* Try to subscribe the TX for reading all words in [address, address + len)
+   */
+  TM2C_CONFLICT_T tm2c_rpc_load_range(tm_addr_t address, size_t len);
+#endif
+
+  /* Split-phase version of tm2c_rpc_load: sends the request without waiting 
+   * for the reply. At most one request per DSL node can be outstanding; a new
+   * request to the same node first collects the previous one (hence the
+   * possible conflict).
+   */
+  TM2C_CONFLICT_T tm2c_rpc_load_async(tm_addr_t address, int words);
+
+  /* Collects the reply of a tm2c_rpc_load_async for the address (or issues a
+   * blocking tm2c_rpc_load if no async load was issued for it)
+   */
+  TM2C_CONFLICT_T tm2c_rpc_load_wait(tm_addr_t address, int words);
+
+  /* Collects the replies of all the outstanding async loads */
+  TM2C_CONFLICT_T tm2c_rpc_load_drain_all(void);
+
   /* Try to publish a write on the address
    * XXX: try to unify the interface
    */
@@ -67,6 +88,19 @@ extern "C" {
   /* Non-transactional write to an address */
   void tm2c_rpc_notx_store(tm_addr_t address, int64_t value);
 
+#if defined(TM2C_RPC_HAS_RMW)
+#  if defined(PGAS)
+  /* Write-locks the address and has the DSL node apply the read-modify-write
+   * operation rmw (tm2c_rmw.h) to it. The old value is in read_value
+   */
+  TM2C_CONFLICT_T tm2c_rpc_rmw(tm_addr_t address, uint32_t rmw, int64_t arg, int64_t arg2);
+#  endif
+  /* Non-transactional read-modify-write: applied at once by the DSL node
+   * (retried while it conflicts). Returns the old value
+   */
+  int64_t tm2c_rpc_notx_rmw(tm_addr_t address, uint32_t rmw, int64_t arg, int64_t arg2);
+#endif	/* TM2C_RPC_HAS_RMW */
+
   /* Load_Rlss the TX from the address
    */
   void tm2c_rpc_load_rls(tm_addr_t address);
@@ -75,6 +109,16 @@ extern "C" {
    */
   void tm2c_rpc_store_rls(tm_addr_t address);
 
+  /* Releases the read lock of the TX for the address (a write lock is kept
+   * until the commit). The DSL node replies whether the TX still holds any
+   * lock on it, so that tm2c_rpc_rls_all can skip it if not
+   */
+  void tm2c_rpc_release(tm_addr_t address);
+  /* Turns the write lock of the TX for the address into a read lock (the
+   * write is dropped)
+   */
+  void tm2c_rpc_downgrade(tm_addr_t address);
+
   void tm2c_rpc_rls_all(TM2C_CONFLICT_T conflict);
 
   void tm2c_rpc_stats(tm2c_tx_node_t* tm2c_tx_node, double duration);
@@ -84,6 +128,48 @@ extern "C" {
    */
   void tm2c_rpc_store_all(void);
 
+#if !defined(PGAS)
+  /* Acquires the write locks for num_entries write entries, batching the
+   * addresses per responsible DSL node (TM2C_RPC_STORE_MULTI). Returns the
+   * first conflict that any of the DSL nodes reported.
+   */
+  TM2C_CONFLICT_T tm2c_rpc_store_multi(write_entry_t* entries, uint32_t num_entries);
+#endif
+
+#if defined(INVISIBLE_READS)
+  /* Validates the invisible reads of the transaction at all contacted nodes
+   */
+  TM2C_CONFLICT_T tm2c_rpc_validate(void);
+
+  /* Validates the read set of the transaction (aborts on a conflict)
+   */
+  void tm2c_rpc_validate_all(void);
+#endif
+
+#if defined(TX_NESTING) && !defined(PGAS)
+  /* Saves the DSL nodes that the tx has contacted to contacted (of
+   * TM2C_MAX_PROCS), at the start of a nested block
+   */
+  void tm2c_rpc_savepoint(unsigned short* contacted);
+
+  /* Collects the outstanding async loads and returns TRUE if the nodes in
+   * contacted still hold the locks of the tx: the nested block that saved
+   * them can be rolled back alone
+   */
+  uint32_t tm2c_rpc_rollback(unsigned short* contacted);
+#endif
+
+#if defined(IRREVOCABLE)
+  /* Gets the irrevocability token (tm2c_irrevoc.h) from the first DSL
+   * node, retrying until it is granted
+   */
+  void tm2c_rpc_irrevoc(void);
+
+  /* Releases the irrevocability token (after tm2c_rpc_rls_all)
+   */
+  void tm2c_rpc_irrevoc_rls(void);
+#endif
+
   TM2C_CONFLICT_T tm2c_rpc_dummy(nodeid_t node);
 
 #ifdef	__cplusplus
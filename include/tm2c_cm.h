@@ -50,11 +50,94 @@ inline ticks greedy_get_global_ts();
 extern BOOLEAN 
 contention_manager(nodeid_t attacker, unsigned short *defenders, TM2C_CONFLICT_T conflict);
 
+/* the priority-based resolution (wholly, greedy, faircm): the tx with the
+   lowest cm_metadata_core timestamp wins, the losers are aborted */
 extern BOOLEAN 
-contention_manager_raw_waw(nodeid_t attacker, unsigned short defender, TM2C_CONFLICT_T conflict);
+cm_priority_raw_waw(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict);
 
+/* defenders: the ids of the num_defenders readers (might include attacker) */
 extern BOOLEAN 
-contention_manager_war(nodeid_t attacker, uint8_t *defenders, TM2C_CONFLICT_T conflict);
+cm_priority_war(nodeid_t attacker, nodeid_t *defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict);
+
+#if defined(DYNAMIC_CM)
+/*
+ * A contention manager selected at run time (-cm=<name>, see tm2c_cm_select)
+ * instead of at compile time. The app-side hooks work on the tx of the
+ * calling node (tm2c_tx, tm2c_tx_node).
+ */
+typedef struct tm2c_cm_ops
+{
+  const char* name;
+  /* app: the priority metadata piggybacked on the requests (tx_metadata) */
+  uint64_t (*tx_metadata)();
+  /* app: on the first start of a tx, on every (re)start, and on commit */
+  void (*on_first_start)();
+  void (*on_start)();
+  void (*on_commit)();
+  /* app: after an abort, before the tx restarts */
+  void (*on_abort)();
+  /* dsl: the priority of sender, from the tx_metadata of its request */
+  void (*priority)(nodeid_t sender, uint64_t tx_metadata);
+  /* dsl: TRUE if the attacker won (the defenders are aborted) */
+  BOOLEAN (*raw_waw)(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict);
+  BOOLEAN (*war)(nodeid_t attacker, nodeid_t* defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict);
+} tm2c_cm_ops_t;
+
+extern const tm2c_cm_ops_t* tm2c_cm;
+
+/* nocm, backoff_retry, wholly, greedy, faircm, or adaptive. Exits on an
+   unknown name */
+extern void tm2c_cm_select(const char* name);
+/* dsl: prints the statistics of the adaptive cm */
+extern void tm2c_cm_term();
+
+/*
+ * The adaptive cm: every DSL core resolves its conflicts as backoff_retry
+ * (the attacker loses) until the conflicts in a window of
+ * ADAPTIVE_CM_WINDOW transactions (that contact the core) exceed
+ * ADAPTIVE_CM_HIGH percent of them, then as greedy until they drop below
+ * ADAPTIVE_CM_LOW percent. The apps always send greedy timestamps and back
+ * off after an abort.
+ */
+#  if !defined(ADAPTIVE_CM_WINDOW)
+#    define ADAPTIVE_CM_WINDOW 256
+#  endif
+#  if !defined(ADAPTIVE_CM_HIGH)
+#    define ADAPTIVE_CM_HIGH   30
+#  endif
+#  if !defined(ADAPTIVE_CM_LOW)
+#    define ADAPTIVE_CM_LOW    10
+#  endif
+
+#  define cm_resolve_raw_waw(attacker, defender, conflict)	\
+  tm2c_cm->raw_waw(attacker, defender, conflict)
+#  define cm_resolve_war(attacker, defenders, num_defenders, conflict) \
+  tm2c_cm->war(attacker, defenders, num_defenders, conflict)
+#else
+#  define cm_resolve_raw_waw(attacker, defender, conflict)	\
+  cm_priority_raw_waw(attacker, defender, conflict)
+#  define cm_resolve_war(attacker, defenders, num_defenders, conflict) \
+  cm_priority_war(attacker, defenders, num_defenders, conflict)
+#endif	/* DYNAMIC_CM */
+
+#if defined(IRREVOCABLE)
+/* the owner of the irrevocability token (tm2c_irrevoc.h) wins every
+   conflict, the others are resolved by cm_resolve_* */
+extern BOOLEAN 
+cm_irrevoc_raw_waw(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict);
+extern BOOLEAN 
+cm_irrevoc_war(nodeid_t attacker, nodeid_t *defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict);
+
+#  define contention_manager_raw_waw(attacker, defender, conflict)	\
+  cm_irrevoc_raw_waw(attacker, defender, conflict)
+#  define contention_manager_war(attacker, defenders, num_defenders, conflict) \
+  cm_irrevoc_war(attacker, defenders, num_defenders, conflict)
+#else
+#  define contention_manager_raw_waw(attacker, defender, conflict)	\
+  cm_resolve_raw_waw(attacker, defender, conflict)
+#  define contention_manager_war(attacker, defenders, num_defenders, conflict) \
+  cm_resolve_war(attacker, defenders, num_defenders, conflict)
+#endif	/* IRREVOCABLE */
 
 void
 contention_manager_pri_print(void);
@@ -35,6 +35,14 @@
 #ifdef PGAS
 extern tm2c_write_set_pgas_t **PGAS_write_sets;
 #endif
+#if defined(PGAS_MVCC)
+#include "pgas_mvcc.h"
+#endif
+#include "dsl_waitq.h"
+#include "tm2c_rmw.h"
+#include "tm2c_irrevoc.h"
+#include "tm2c_profile.h"
+#include "tm2c_histo.h"
 
 void tm2c_dsl_init(void);
 
@@ -42,6 +50,7 @@ void dsl_service();
 
 INLINED TM2C_CONFLICT_T try_load(nodeid_t nodeId, tm_intern_addr_t tm_address);
 INLINED TM2C_CONFLICT_T try_store(nodeid_t nodeId, tm_intern_addr_t tm_address);
+INLINED TM2C_CONFLICT_T try_store_multi(nodeid_t nodeId, TM2C_RPC_REQ* req);
 
 void tm2c_dsl_print_global_stats();
 void print_hashtable_usage();
@@ -70,6 +79,105 @@ try_store(nodeid_t nodeId, tm_intern_addr_t tm_address)
   return tm2c_ht_insert(tm2c_ht, nodeId, tm_address, WRITE);
 }
 
+/* try to acquire the write locks for all the addresses carried by a 
+ * TM2C_RPC_STORE_MULTI request. Stops on the first conflict; the caller 
+ * releases whatever was acquired with tm2c_ht_delete_node.
+ */
+INLINED TM2C_CONFLICT_T
+try_store_multi(nodeid_t nodeId, TM2C_RPC_REQ* req)
+{
+  uint32_t i;
+  for (i = 0; i < TM2C_RPC_MULTI_NUM_WORDS(req); i++)
+    {
+      TM2C_CONFLICT_T conflict = try_store(nodeId, TM2C_RPC_MULTI_ADDR(req, i));
+      if (conflict != NO_CONFLICT)
+	{
+	  return conflict;
+	}
+    }
+  return NO_CONFLICT;
+}
+
+#if defined(TM2C_RANGE_LOCKS)
+INLINED TM2C_CONFLICT_T
+try_load_range(nodeid_t nodeId, tm_intern_addr_t tm_address, size_t len) 
+{
+  return tm2c_ht_insert_range(tm2c_ht, nodeId, tm_address, len);
+}
+#endif	/* TM2C_RANGE_LOCKS */
+
+#if defined(INVISIBLE_READS)
+INLINED TM2C_CONFLICT_T
+try_validate(nodeid_t nodeId) 
+{
+  return tm2c_ht_validate(tm2c_ht, nodeId);
+}
+#endif	/* INVISIBLE_READS */
+
+#if defined(PGAS_MVCC)
+/* a snapshot read does not register in the hashtable */
+INLINED TM2C_CONFLICT_T
+try_load_snapshot(nodeid_t nodeId, tm_intern_addr_t tm_address, uint64_t packed, int64_t* val) 
+{
+  return pgas_mvcc_read(tm_address, packed, tm2c_ht_writer(tm2c_ht, tm_address), val);
+}
+#endif	/* PGAS_MVCC */
+
+#if defined(TM2C_RPC_HAS_RMW)
+#  if defined(PGAS)
+/* TM2C_RPC_RMW: write-locks the address and buffers the new value in the
+   write set of nodeId. *old is the value that the transaction sees (the
+   words are 64-bit wide in the write set, as with TM2C_RPC_STORE) */
+INLINED TM2C_CONFLICT_T
+try_rmw(nodeid_t nodeId, TM2C_RPC_REQ* req, int64_t* old)
+{
+  TM2C_CONFLICT_T conflict = try_store(nodeId, req->address);
+  if (conflict == NO_CONFLICT)
+    {
+      write_entry_pgas_t* we = write_set_pgas_contains(PGAS_write_sets[nodeId], req->address);
+      if (we != NULL)
+	{
+	  *old = (req->rmw_op & TM2C_RMW_64) ? we->value : (int32_t) we->value;
+	  we->value = tm2c_rmw_apply(req->rmw_op, *old, req->write_value, req->rmw_arg);
+	}
+      else
+	{
+	  *old = tm2c_rmw_load(pgas_dsl_readp(req->address), req->rmw_op);
+	  write_set_pgas_insert(PGAS_write_sets[nodeId],
+				tm2c_rmw_apply(req->rmw_op, *old, req->write_value, req->rmw_arg),
+				req->address);
+	}
+    }
+  return conflict;
+}
+#  endif	/* PGAS */
+
+/* TM2C_RPC_RMW_NONTX: a transaction of a single read-modify-write, thus it
+   is applied to the memory and the write lock is released right away */
+INLINED TM2C_CONFLICT_T
+try_rmw_nontx(nodeid_t nodeId, TM2C_RPC_REQ* req, int64_t* old)
+{
+  TM2C_CONFLICT_T conflict = try_store(nodeId, req->address);
+  if (conflict == NO_CONFLICT)
+    {
+#  if defined(PGAS)
+      *old = tm2c_rmw_load(pgas_dsl_readp(req->address), req->rmw_op);
+#    if defined(PGAS_MVCC)
+      pgas_mvcc_write_nontx(req->address, tm2c_rmw_apply(req->rmw_op, *old, req->write_value, req->rmw_arg));
+#    else
+      pgas_dsl_write(req->address, tm2c_rmw_apply(req->rmw_op, *old, req->write_value, req->rmw_arg));
+#    endif	/* PGAS_MVCC */
+#  else
+      void* addr = (void*) to_addr(req->address);
+      *old = tm2c_rmw_load(addr, req->rmw_op);
+      tm2c_rmw_store(addr, req->rmw_op, tm2c_rmw_apply(req->rmw_op, *old, req->write_value, req->rmw_arg));
+#  endif	/* PGAS */
+      tm2c_ht_delete(tm2c_ht, nodeId, req->address, WRITE);
+    }
+  return conflict;
+}
+#endif	/* TM2C_RPC_HAS_RMW */
+
 INLINED void
 load_rls(nodeid_t nodeId, tm_intern_addr_t tm_address)
 {
@@ -46,6 +46,7 @@ extern "C" {
  * tm2c_ht_t denotes the type of the hashtable. It should be customized
  * to each type of hashtable we use.
  * USE_HASHTABLE_SSHT:     Super-Simple-HT (counting readers)
+ * USE_HASHTABLE_OAHT:     Open-Addressing-HT (resizable, same entries as SSHT)
  */
     
 #if USE_HASHTABLE_SSHT
@@ -54,6 +55,11 @@ extern "C" {
 #  include "ssht_log.h"
   typedef ssht_hashtable_t tm2c_ht_t;
 
+#elif USE_HASHTABLE_OAHT
+
+#  include "oaht.h"
+  typedef oaht_hashtable_t tm2c_ht_t;
+
 #else
 #  error "** No type of hashtable implementation given."
 #endif
@@ -68,6 +74,13 @@ extern tm2c_ht_t tm2c_ht_new();
  */
 extern void tm2c_ht_free(tm2c_ht_t ht);
 
+/*
+ * With INVISIBLE_READS, a reader is not inserted in the hashtable: the
+ * version of the address (a per-stripe counter, increased every time a write
+ * lock is released) is instead appended to the read log of the node.
+ */
+#define TM2C_HT_VERSION_STRIPES 4096
+
 /*
  * insert a reader of writer for the address into the hashatable. The hashtable is the constract that keeps
  * all the metadata for the addresses that the node is responsible.
@@ -77,6 +90,53 @@ extern void tm2c_ht_free(tm2c_ht_t ht);
 extern TM2C_CONFLICT_T tm2c_ht_insert(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
                                 tm_intern_addr_t address, RW rw);
 
+#if defined(TM2C_RANGE_LOCKS)
+/*
+ * insert a reader for all the words in [address, address + len).
+ *
+ * Returns: type of TM conflict caused by inserting given values
+ */
+extern TM2C_CONFLICT_T tm2c_ht_insert_range(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
+					    tm_intern_addr_t address, size_t len);
+#endif	/* TM2C_RANGE_LOCKS */
+
+#if defined(INVISIBLE_READS)
+/*
+ * validate the reads of the node (see tm2c_ht_insert), i.e., that no other
+ * node has written or holds the write lock for any of them
+ *
+ * Returns: NO_CONFLICT or WRITE_AFTER_READ
+ */
+extern TM2C_CONFLICT_T tm2c_ht_validate(tm2c_ht_t tm2c_ht, nodeid_t nodeId);
+#endif	/* INVISIBLE_READS */
+
+#if defined(PGAS_MVCC)
+/*
+ * Returns: the node that holds the write lock for the address, or -1
+ */
+extern int32_t tm2c_ht_writer(tm2c_ht_t tm2c_ht, tm_intern_addr_t address);
+#endif	/* PGAS_MVCC */
+
+#if defined(TX_PROFILE)
+/*
+ * address: the address of a request that conflicted, set to the word that
+ * conflicted for a range.
+ * Returns: a node other than nodeId that holds the address (the writer
+ * first), or TX_PROFILE_NO_NODE
+ */
+extern nodeid_t tm2c_ht_holder(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
+			       tm_intern_addr_t* address);
+#endif	/* TX_PROFILE */
+
+#if defined(DSL_WAITQ)
+/*
+ * Returns: TRUE if the nodes that hold the address (that nodeId conflicts
+ * with) all have lower ids than nodeId
+ */
+extern uint32_t tm2c_ht_holders_below(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
+				      tm_intern_addr_t address);
+#endif	/* DSL_WAITQ */
+
 /*
  * delete a reader of writer for the address from the hashatable.
  */
@@ -85,11 +145,32 @@ extern void tm2c_ht_delete(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
 
 extern void tm2c_ht_delete_node(tm2c_ht_t tm2c_ht, nodeid_t nodeId);
 
+/*
+ * release the read lock of the node for the address (a write lock is kept).
+ *
+ * Returns: TRUE if the node still holds any lock (or logged read)
+ */
+extern uint32_t tm2c_ht_release(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
+				tm_intern_addr_t address);
+
+/*
+ * turn the write lock of the node for the address (if any) into a read lock
+ */
+extern void tm2c_ht_downgrade(tm2c_ht_t tm2c_ht, nodeid_t nodeId,
+			      tm_intern_addr_t address);
+
 /*
  * traverse and print the hastable contents
  */
 extern void tm2c_ht_print(tm2c_ht_t tm2c_ht);
 
+#if defined(STATS_EXPORT)
+/*
+ * add the utilization of the hashtable to the stats record being written
+ */
+extern void tm2c_ht_stats_export(tm2c_ht_t tm2c_ht);
+#endif	/* STATS_EXPORT */
+
 #ifdef    __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+/*
+ *   File: tm2c_histo.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: log-bucketed latency histograms of the transactions, the
+ *                RPCs, and the commit phases (TX_HISTO)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Every app core counts the latencies (in getticks() cycles) of its
+ * transactions, of the round-trips of tm2c_rpc_load / tm2c_rpc_store, and of
+ * the commits and their phases in histograms. As in HDR histograms, every
+ * power of 2 is split in TM2C_HISTO_SUB linear sub-buckets, thus a value is
+ * counted with an error below 1 / TM2C_HISTO_SUB (the values below
+ * TM2C_HISTO_SUB are exact), and the recording is a count increment.
+ *
+ * At tm2c_rpc_stats, every app sends the non-empty buckets
+ * (TM2C_RPC_HISTO) to the first DSL core, before the stats messages, which
+ * merges them and prints the percentiles with the global stats.
+ */
+
+#ifndef _TM2C_HISTO_H_
+#define _TM2C_HISTO_H_
+
+#include "common.h"
+
+#if defined(TX_HISTO)
+
+#  if defined(PLATFORM_TILERA) || defined(PLATFORM_NIAGARA)
+#    error "TX_HISTO: the messages on the Tilera and the Niagara have no room for the buckets"
+#  endif
+
+#define TM2C_HISTO_SUB_BITS    4
+#define TM2C_HISTO_SUB         (1 << TM2C_HISTO_SUB_BITS)
+#define TM2C_HISTO_BUCKETS     ((64 - TM2C_HISTO_SUB_BITS + 1) * TM2C_HISTO_SUB)
+#define TM2C_HISTO_MSG_BUCKETS 7 /* buckets per message */
+
+typedef enum
+  {
+    TM2C_HISTO_TX,		/* first TX_START to the commit, with the retries */
+    TM2C_HISTO_LOAD,		/* round-trip of tm2c_rpc_load */
+    TM2C_HISTO_STORE,		/* round-trip of tm2c_rpc_store */
+    TM2C_HISTO_COMMIT,		/* TX_COMMIT */
+    TM2C_HISTO_COMMIT_ACQ,	/* TX_COMMIT: write locks and validation */
+    TM2C_HISTO_COMMIT_PERSIST,	/* TX_COMMIT: write-back */
+    TM2C_HISTO_COMMIT_RLS,	/* TX_COMMIT: release of the locks */
+    TM2C_HISTO_NUM
+  } TM2C_HISTO_T;
+
+typedef uint32_t tm2c_histo_t[TM2C_HISTO_BUCKETS];
+
+/* non-empty buckets of a histogram, as a message */
+typedef struct tm2c_histo_msg
+{
+  int32_t type;			/* TM2C_RPC_HISTO */
+  nodeid_t nodeId;
+  uint16_t histo;		/* TM2C_HISTO_T */
+  uint16_t num;
+  uint16_t bucket[TM2C_HISTO_MSG_BUCKETS];
+  uint32_t count[TM2C_HISTO_MSG_BUCKETS];
+} tm2c_histo_msg_t;
+
+/* app: of this core, dsl: the merged ones */
+extern tm2c_histo_t tm2c_histos[TM2C_HISTO_NUM];
+
+INLINED uint32_t
+tm2c_histo_bucket(ticks value)
+{
+  if (value < TM2C_HISTO_SUB)
+    {
+      return value;
+    }
+  uint32_t msb = 63 - __builtin_clzll(value);
+  return ((msb - TM2C_HISTO_SUB_BITS + 1) << TM2C_HISTO_SUB_BITS)
+    + ((value >> (msb - TM2C_HISTO_SUB_BITS)) & (TM2C_HISTO_SUB - 1));
+}
+
+INLINED void
+tm2c_histo_add(TM2C_HISTO_T histo, ticks value)
+{
+  tm2c_histos[histo][tm2c_histo_bucket(value)]++;
+}
+
+#  define TM2C_HISTO_RPC_START()   ticks histo_rpc_start = getticks();
+#  define TM2C_HISTO_RPC_END(histo)			\
+  tm2c_histo_add(histo, getticks() - histo_rpc_start);
+
+/* app: sends the histograms to the first DSL core */
+extern void tm2c_histo_send();
+
+/* dsl */
+extern void tm2c_histo_merge(tm2c_histo_msg_t* msg);
+extern void tm2c_histo_print();
+
+#  if defined(STATS_EXPORT)
+/* adds the percentiles of the histograms to the stats record being written */
+extern void tm2c_histo_stats_export();
+#  endif
+
+#else  /* !TX_HISTO */
+
+#  define TM2C_HISTO_RPC_START()
+#  define TM2C_HISTO_RPC_END(histo)
+
+#endif	/* TX_HISTO */
+
+#endif	/* _TM2C_HISTO_H_ */
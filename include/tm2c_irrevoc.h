@@ -0,0 +1,74 @@
+/*
+ *   File: tm2c_irrevoc.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: the system-wide token of the irrevocable transactions
+ *                (IRREVOCABLE)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * A transaction that is about to start its IRREVOCABLE_RETRIES + 1 try
+ * (after it released everything on its last abort) asks the first DSL core
+ * for the token (TM2C_RPC_IRREVOC), and retries until it gets it. The owner
+ * of the token is in shared memory, which all DSL cores map, and their
+ * contention managers let the owner win every conflict: its requests abort
+ * the holders, and the requests that conflict with it are aborted.
+ *
+ * The owner can still abort for reasons that are not conflicts with others
+ * (e.g., a failed validation with INVISIBLE_READS). It then keeps the token,
+ * and releases it (TM2C_RPC_IRREVOC_RLS) after the releases of its commit.
+ */
+
+#ifndef _TM2C_IRREVOC_H_
+#define _TM2C_IRREVOC_H_
+
+#include "common.h"
+
+#if defined(IRREVOCABLE)
+
+#  if defined(NOCM) || defined(BACKOFF_RETRY)
+#    error "IRREVOCABLE needs a contention manager that can abort the holders"
+#  endif
+
+#  if !defined(IRREVOCABLE_RETRIES)
+#    define IRREVOCABLE_RETRIES 16
+#  endif
+
+#define TM2C_IRREVOC_NONE ((nodeid_t) -1)
+
+extern volatile nodeid_t* tm2c_irrevoc_owner;
+
+/* dsl: called by every DSL core before the init barrier */
+extern void tm2c_irrevoc_init();
+extern void tm2c_irrevoc_term();
+
+/* dsl: NO_CONFLICT if sender got the token */
+extern TM2C_CONFLICT_T tm2c_irrevoc_grant(nodeid_t sender);
+extern void tm2c_irrevoc_release(nodeid_t sender);
+
+INLINED uint32_t
+tm2c_irrevoc_is_owner(nodeid_t node)
+{
+  return *tm2c_irrevoc_owner == node;
+}
+
+#endif	/* IRREVOCABLE */
+
+#endif	/* _TM2C_IRREVOC_H_ */
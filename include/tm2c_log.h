@@ -38,15 +38,24 @@ extern "C" {
 #endif
 
 #include "common.h"
+#include "hash.h"
 
 #define CAST_INT(addr) *(addr)
 
+  /* TYPE_INT is 32 bits. Any other type (e.g., double) can be stored
+     with TX_STORE_BLOCK */
   typedef enum 
     {
       TYPE_INT,
-      TYPE_INT64
+      TYPE_INT64,
+      TYPE_INT8,
+      TYPE_INT16,
+      TYPE_BLOCK
     } DATATYPE;
 
+#define TYPE_INT32 TYPE_INT
+#define TYPE_PTR   ((sizeof(void*) == 8) ? TYPE_INT64 : TYPE_INT)
+
 
   /*______________________________________________________________________________________________________
    * WRITE SET                                                                                             |
@@ -56,18 +65,90 @@ extern "C" {
 
 #define WRITE_SET_SIZE 4
 
+  /*
+   * The entries are kept in insertion order (the same address can be in
+   * more than once; the last one is the current value). Up to
+   * WRITE_SET_INDEX_MIN entries, the set is scanned linearly. Beyond that,
+   * an open-addressing index maps the addresses to their last entry. The
+   * slots of the index are stamped with the epoch of the set, so that
+   * emptying the set only increments the epoch. A one-word bloom filter
+   * answers most of the misses (the common case of tx_load) without
+   * touching the entries or the index.
+   *
+   * A TYPE_BLOCK entry buffers len bytes (copied to the blocks of the set)
+   * and is indexed under (and locked at commit on) every WRITE_SET_WORD
+   * word it covers, so that loads of any of its fields find it. So is a
+   * TYPE_INT64 entry, under its two words.
+   *
+   * With WRITE_BACK_RUNS, if the entries were inserted in increasing
+   * address order (e.g., array updates), the contiguous ones are staged and
+   * written back on commit with one (wide) copy per run of up to
+   * WRITE_BACK_RUN bytes; with WRITE_BACK_RUNS = 2, the whole cache lines of
+   * a run are written with non-temporal stores. Otherwise, the entries are
+   * written back one by one, in insertion order.
+   */
+#define WRITE_SET_INDEX_MIN  16
+#define WRITE_SET_INDEX_SIZE 64	/* initial, power of 2 */
+
+#define WRITE_SET_HASH(addr)  hash_tw((uint32_t) ((addr) >> 2))
+#define WRITE_SET_BLOOM(hash) (1ULL << ((hash) >> 26))
+#define WRITE_SET_WORD        sizeof(int32_t)
+#define WRITE_SET_BLOCKS_SIZE 256	/* initial bytes of the blocks */
+
   typedef struct write_entry 
   {
     tm_intern_addr_t address;
     DATATYPE type;
-    int32_t i;
+    uint32_t len;		/* TYPE_BLOCK: bytes, at offset i64 of the blocks */
+    union
+    {
+      int8_t i8;
+      int16_t i16;
+      int32_t i;
+      int64_t i64;
+    };
   } write_entry_t;
 
+/* words under which the entry is indexed (and locked at commit) */
+#define WRITE_ENTRY_WORDS(we)						\
+  (((we)->type == TYPE_BLOCK) ? ((we)->len + WRITE_SET_WORD - 1) / WRITE_SET_WORD : \
+   ((we)->type == TYPE_INT64) ? 2 : 1)
+/* bytes written by the entry */
+#define WRITE_ENTRY_SIZE(we)						\
+  (((we)->type == TYPE_BLOCK) ? (we)->len :				\
+   ((we)->type == TYPE_INT8) ? 1 : ((we)->type == TYPE_INT16) ? 2 :	\
+   ((we)->type == TYPE_INT64) ? 8 : 4)
+/* the entry is indexed under addr */
+#define WRITE_ENTRY_COVERS(we, addr)					\
+  ((addr) == (we)->address ||						\
+   ((we)->type == TYPE_INT64 && (addr) == (we)->address + WRITE_SET_WORD) || \
+   ((we)->type == TYPE_BLOCK && (addr) - (we)->address < (we)->len &&	\
+    ((addr) - (we)->address) % WRITE_SET_WORD == 0))
+
+  typedef struct write_set_slot
+  {
+    tm_intern_addr_t address;
+    uint32_t epoch;		/* valid if equal to the epoch of the set */
+    uint32_t entry;
+  } write_set_slot_t;
+
   typedef struct write_set 
   {
     write_entry_t* write_entries;
     uint32_t nb_entries;
     uint32_t size;
+    uint32_t nb_words;		/* locked at commit, indexed */
+    uint64_t bloom;
+    write_set_slot_t* index;
+    uint32_t index_size;
+    uint32_t epoch;
+    uint8_t* blocks;
+    uint32_t blocks_used;
+    uint32_t blocks_size;
+#if defined(WRITE_BACK_RUNS)
+    uint32_t ordered;		/* increasing, non-overlapping addresses */
+    tm_intern_addr_t end;	/* of the last entry */
+#endif	/* WRITE_BACK_RUNS */
   } tm2c_write_set_t;
 
   extern tm2c_write_set_t* write_set_new();
@@ -76,13 +157,23 @@ extern "C" {
 
   extern tm2c_write_set_t* write_set_empty(tm2c_write_set_t* write_set);
 
+  /* drops the entries after the first nb_entries (and their blocks after
+     blocks_used): the rollback of a nested block */
+  extern void write_set_truncate(tm2c_write_set_t* write_set, uint32_t nb_entries, uint32_t blocks_used);
+
+  /* drops the (word) entries of address, but not the TYPE_BLOCK ones that
+     cover it. Returns the number of dropped entries */
+  extern uint32_t write_set_remove(tm2c_write_set_t* write_set, tm_intern_addr_t address);
+
   inline write_entry_t* write_set_entry(tm2c_write_set_t* write_set);
 
-  inline void write_entry_set_value(write_entry_t* we, int32_t value);
+  inline void write_entry_set_value(write_entry_t* we, int64_t value);
+
+  extern void write_set_insert(tm2c_write_set_t* write_set, DATATYPE datatype, int64_t value, tm_intern_addr_t address);
 
-  extern void write_set_insert(tm2c_write_set_t* write_set, DATATYPE datatype, int32_t value, tm_intern_addr_t address);
+  extern write_entry_t* write_set_insert_block(tm2c_write_set_t* write_set, const void* src, uint32_t len, tm_intern_addr_t address);
 
-  extern void write_set_update(tm2c_write_set_t* write_set, DATATYPE datatype, int32_t value, tm_intern_addr_t address);
+  extern void write_set_update(tm2c_write_set_t* write_set, DATATYPE datatype, int64_t value, tm_intern_addr_t address);
 
   extern void write_entry_persist(write_entry_t* we);
 
@@ -94,6 +185,17 @@ extern "C" {
 
   extern write_entry_t* write_set_contains(tm2c_write_set_t* write_set, tm_intern_addr_t address);
 
+  /* the buffered value of address, in the entry we found by write_set_contains */
+  INLINED void*
+  write_entry_value(tm2c_write_set_t* write_set, write_entry_t* we, tm_intern_addr_t address)
+  {
+    if (we->type == TYPE_BLOCK)
+      {
+	return write_set->blocks + we->i64 + (address - we->address);
+      }
+    return (uint8_t*) &we->i64 + (address - we->address);
+  }
+
 #ifdef PGAS
 
 #  include "pgas_dsl.h"
@@ -118,6 +220,9 @@ extern "C" {
     write_entry_pgas_t *write_entries;
     uint32_t nb_entries;
     uint32_t size;
+#if defined(PGAS_MVCC)
+    nodeid_t owner;		/* the versions are stamped with its commit ts */
+#endif	/* PGAS_MVCC */
   } tm2c_write_set_pgas_t;
 
   extern tm2c_write_set_pgas_t* write_set_pgas_new();
@@ -132,6 +237,8 @@ extern "C" {
 
   extern void write_set_pgas_update(tm2c_write_set_pgas_t *write_set_pgas, int64_t value, tm_intern_addr_t address);
 
+  extern void write_set_pgas_remove(tm2c_write_set_pgas_t *write_set_pgas, tm_intern_addr_t address);
+
   inline void write_entry_pgas_persist(write_entry_pgas_t *we);
 
   inline void write_entry_pgas_print(write_entry_pgas_t *we);
@@ -104,6 +104,12 @@ extern "C" {
      */
   void mem_info_on_abort(mem_info_t *stm_mem_info);
 
+    /*
+     * Called upon the rollback of a nested block (saved holds the heads of
+     * the lists at its start).
+     */
+  void mem_info_on_rollback(mem_info_t *stm_mem_info, mem_info_t *saved);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,112 @@
+/*
+ *   File: tm2c_profile.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: attribution of the aborts to transaction sites,
+ *                conflicting addresses, and winners (TX_PROFILE)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * TX_START records the site (__FILE__, __LINE__) of the transaction. A DSL
+ * core that replies with a conflict puts a holder of the address (the
+ * winner) in the nodeId of the reply, and the app keeps the address and the
+ * winner of the last conflict. On an abort, the app counts it under the key
+ * (site, address, conflict type, winner) in a table. An abort by a
+ * contention manager of another DSL core (see TXCHKABORTED), or by a failed
+ * validation (INVISIBLE_READS), has no address and no winner.
+ *
+ * At tm2c_rpc_stats, every app sends its records (TM2C_RPC_PROFILE) to the
+ * first DSL core, before the stats messages, which merges them and prints
+ * the TX_PROFILE_TOP hottest addresses and sites with the global stats.
+ * The file names are pointers to the (same) binary of all the cores.
+ */
+
+#ifndef _TM2C_PROFILE_H_
+#define _TM2C_PROFILE_H_
+
+#include "common.h"
+
+#if defined(TX_PROFILE)
+
+#  if defined(PLATFORM_TILERA) || defined(PLATFORM_NIAGARA)
+#    error "TX_PROFILE: the replies on the Tilera and the Niagara have no room for the address"
+#  endif
+
+#  if !defined(TX_PROFILE_TOP)
+#    define TX_PROFILE_TOP 10
+#  endif
+
+#define TX_PROFILE_SIZE      16384	/* records per app, power of 2 */
+#define TX_PROFILE_DSL_SIZE  65536	/* records at the DSL, power of 2 */
+#define TX_PROFILE_NO_NODE   ((nodeid_t) -1)
+
+typedef struct tm2c_profile_rec
+{
+  const char* file;
+  uint32_t line;
+  uint32_t conflict;		/* TM2C_CONFLICT_T */
+  tm_intern_addr_t address;
+  nodeid_t winner;
+  uint32_t count;
+} tm2c_profile_rec_t;
+
+/* a record, as a message (the last word of SSMP messages is a flag) */
+typedef struct tm2c_profile_msg
+{
+  int32_t type;			/* TM2C_RPC_PROFILE */
+  nodeid_t nodeId;
+  const char* file;
+  tm_intern_addr_t address;
+  uint32_t line;
+  uint32_t count;
+  uint16_t conflict;
+  uint16_t winner;
+} tm2c_profile_msg_t;
+
+/* app: the address and the winner of the last conflict reply */
+extern tm_intern_addr_t tm2c_profile_addr;
+extern nodeid_t tm2c_profile_winner;
+
+INLINED void
+tm2c_profile_note(tm_intern_addr_t address, nodeid_t winner)
+{
+  tm2c_profile_addr = address;
+  tm2c_profile_winner = winner;
+}
+
+INLINED void
+tm2c_profile_forget()
+{
+  tm2c_profile_winner = TX_PROFILE_NO_NODE;
+  tm2c_profile_addr = 0;
+}
+
+/* app: counts an abort of the tx of site (file, line) */
+extern void tm2c_profile_abort(const char* file, uint32_t line, TM2C_CONFLICT_T reason);
+/* app: sends the records to the first DSL core */
+extern void tm2c_profile_send();
+
+/* dsl */
+extern void tm2c_profile_merge(tm2c_profile_msg_t* msg);
+extern void tm2c_profile_print();
+
+#endif	/* TX_PROFILE */
+
+#endif	/* _TM2C_PROFILE_H_ */
@@ -0,0 +1,123 @@
+/*
+ *   File: tm2c_rmw.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: the read-modify-write operations that the DSL nodes
+ *                execute (TX_RMW, NONTX_RMW, TX_CAS)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * An operation is a TM2C_RMW_OP, or-ed with TM2C_RMW_64 if it is on a 64-bit
+ * word (else on a 32-bit one). It is applied to the old value of the word
+ * and one operand (arg), or two for TM2C_RMW_CAS (arg is the expected value
+ * and arg2 the new one). The values of 32-bit words are sign extended.
+ */
+
+#ifndef _TM2C_RMW_H_
+#define _TM2C_RMW_H_
+
+#include "common.h"
+
+typedef enum
+  {
+    TM2C_RMW_ADD,
+    TM2C_RMW_MIN,
+    TM2C_RMW_MAX,
+    TM2C_RMW_AND,
+    TM2C_RMW_OR,
+    TM2C_RMW_XOR,
+    TM2C_RMW_CAS
+  } TM2C_RMW_OP;
+
+#define TM2C_RMW_64              0x100
+#define TM2C_RMW_OP_OF(rmw)      ((rmw) & 0xff)
+/* the operation op on a word of type datatype (TYPE_INT or TYPE_INT64) */
+#define TM2C_RMW_FOR(op, datatype)					\
+  ((op) | (((datatype) == TYPE_INT64) ? TM2C_RMW_64 : 0))
+
+/* returns the new value of a word with value old */
+INLINED int64_t
+tm2c_rmw_apply(uint32_t rmw, int64_t old, int64_t arg, int64_t arg2)
+{
+  int64_t val;
+  if (!(rmw & TM2C_RMW_64))
+    {
+      arg = (int32_t) arg;
+      arg2 = (int32_t) arg2;
+    }
+
+  switch (TM2C_RMW_OP_OF(rmw))
+    {
+    case TM2C_RMW_ADD:
+      val = (int64_t) ((uint64_t) old + (uint64_t) arg);
+      break;
+    case TM2C_RMW_MIN:
+      val = (arg < old) ? arg : old;
+      break;
+    case TM2C_RMW_MAX:
+      val = (arg > old) ? arg : old;
+      break;
+    case TM2C_RMW_AND:
+      val = old & arg;
+      break;
+    case TM2C_RMW_OR:
+      val = old | arg;
+      break;
+    case TM2C_RMW_XOR:
+      val = old ^ arg;
+      break;
+    case TM2C_RMW_CAS:
+      val = (old == arg) ? arg2 : old;
+      break;
+    default:
+      val = old;
+    }
+
+  if (!(rmw & TM2C_RMW_64))
+    {
+      return (int32_t) val;
+    }
+  return val;
+}
+
+INLINED int64_t
+tm2c_rmw_load(void* addr, uint32_t rmw)
+{
+  if (rmw & TM2C_RMW_64)
+    {
+      return *(int64_t*) addr;
+    }
+  return *(int32_t*) addr;
+}
+
+INLINED void
+tm2c_rmw_store(void* addr, uint32_t rmw, int64_t val)
+{
+  if (rmw & TM2C_RMW_64)
+    {
+      *(int64_t*) addr = val;
+    }
+  else
+    {
+      *(int32_t*) addr = (int32_t) val;
+    }
+}
+
+#endif	/* _TM2C_RMW_H_ */
@@ -45,7 +45,20 @@ extern "C" {
       TM2C_RPC_STORE_NONTX,		//6
       TM2C_RPC_STORE_INC,		//7
       TM2C_RPC_STATS,			//8
-      TM2C_RPC_UKNOWN			//9
+      TM2C_RPC_STORE_MULTI,		//9
+      TM2C_RPC_LOAD_RANGE,		//10
+      TM2C_RPC_VALIDATE,		//11
+      TM2C_RPC_LOAD_SNAPSHOT,		//12
+      TM2C_RPC_STORE_COMMIT,		//13
+      TM2C_RPC_RMW,			//14
+      TM2C_RPC_RMW_NONTX,		//15
+      TM2C_RPC_IRREVOC,		//16
+      TM2C_RPC_IRREVOC_RLS,		//17
+      TM2C_RPC_RELEASE,		//18
+      TM2C_RPC_DOWNGRADE,		//19
+      TM2C_RPC_PROFILE,		//20
+      TM2C_RPC_HISTO,		//21
+      TM2C_RPC_UKNOWN			//22
     } TM2C_RPC_REQ_TYPE;
 
   typedef enum 
@@ -55,6 +68,7 @@ extern "C" {
       TM2C_RPC_ABORTED,
       TM2C_RPC_LOAD_NONTX_RESPONSE,
       TM2C_RPC_STORE_NONTX_RESPONSE,
+      TM2C_RPC_RELEASE_RESPONSE,	/* response: the sender still holds locks */
       TM2C_RPC_UKNOWN_RESPONSE
     } TM2C_RPC_REPLY_TYPE;
 
@@ -62,7 +76,7 @@ extern "C" {
   /* A command to the DSL service */
 #if defined(PLATFORM_TILERA)
 
-#  if defined(WHOLLY) || defined(GREEDY) || defined(FAIRCM) || defined(PGAS)
+#  if defined(WHOLLY) || defined(GREEDY) || defined(FAIRCM) || defined(DYNAMIC_CM) || defined(PGAS)
 #    if defined(__tilegx__)
 #      define TM2C_RPC_REQ_SIZE       24
 #      define TM2C_RPC_REQ_SIZE_WORDS 3
@@ -96,6 +110,11 @@ extern "C" {
     };
     /* OPTIONAL based on PGAS and NOCM */
   } TM2C_RPC_REQ;
+
+  /* no room for more addresses: TM2C_RPC_STORE_MULTI carries one address */
+#  define TM2C_RPC_MULTI_NUM              1
+#  define TM2C_RPC_MULTI_NUM_WORDS(req)   1
+#  define TM2C_RPC_MULTI_ADDR(req, i)     ((req)->address)
   
 
 #  if defined(PGAS)
@@ -188,6 +207,10 @@ typedef struct tm2c_rpc_stats_struct
       uint64_t tx_metadata;	/* 8 */
     };
   } TM2C_RPC_REQ;
+
+#  define TM2C_RPC_MULTI_NUM              1
+#  define TM2C_RPC_MULTI_NUM_WORDS(req)   1
+#  define TM2C_RPC_MULTI_ADDR(req, i)     ((req)->address)
   
 
 #    define TM2C_RPC_REPLY_SIZE       TM2C_RPC_REQ_SIZE
@@ -267,6 +290,23 @@ typedef struct tm2c_rpc_stats_send
 #else  /* !PLATFORM_TILERA && !NIAGARA                                                                    */
   /* ____________________________________________________________________________________________________ */
 
+  /* max number of addresses that a single TM2C_RPC_STORE_MULTI can carry */
+#  if defined(SSMP)
+  /* TM2C_RPC_RMW[_NONTX] carry the operation and its second operand in
+     the padding (write_value is the first one) */
+#    define TM2C_RPC_HAS_RMW
+#  endif
+
+#  if defined(SSMP) && !defined(SCC)
+#    define TM2C_RPC_MULTI_NUM              4
+#    define TM2C_RPC_MULTI_NUM_WORDS(req)   ((req)->num_words)
+#    define TM2C_RPC_MULTI_ADDR(req, i)     ((i) == 0 ? (req)->address : (req)->multi_address[(i) - 1])
+#  else
+#    define TM2C_RPC_MULTI_NUM              1
+#    define TM2C_RPC_MULTI_NUM_WORDS(req)   1
+#    define TM2C_RPC_MULTI_ADDR(req, i)     ((req)->address)
+#  endif
+
   typedef struct tm2c_rpc_req_struct 
   {
     int32_t type;	      /* TM2C_RPC_REQ_TYPE */
@@ -287,7 +327,19 @@ typedef struct tm2c_rpc_stats_send
 #  endif
     /* SSMP[.SCC] uses the last word as a flag, hence it should be not used for data */
 #  if defined(SSMP)
-    uint8_t padding[32];
+    union
+    {
+#    if !defined(SCC)
+      /* TM2C_RPC_STORE_MULTI: addresses 1..num_words-1 (address holds the first one) */
+      tm_intern_addr_t multi_address[TM2C_RPC_MULTI_NUM - 1];
+#    endif
+      struct			/* TM2C_RPC_RMW[_NONTX] */
+      {
+	int64_t rmw_arg;
+	uint32_t rmw_op;	/* TM2C_RMW_OP | TM2C_RMW_64 */
+      };
+      uint8_t padding[32];
+    };
 #  endif
   } TM2C_RPC_REQ;
 
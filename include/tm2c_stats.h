@@ -0,0 +1,94 @@
+/*
+ *   File: tm2c_stats.h
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: machine-readable export of the per-node statistics
+ *                (STATS_EXPORT)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Every app and DSL core appends records of its statistics to
+ * STATS_EXPORT_FILE: every STATS_EXPORT_PERIOD seconds (if not 0) from a
+ * sampling thread, and once at the end (final = 1), app cores in
+ * tm2c_rpc_stats and DSL cores when they have received all the stats.
+ *
+ * STATS_EXPORT_JSON: a record is a JSON object in a line,
+ *   {"node":1,"role":"app","time":2.000,"final":0,"commits":...}
+ * STATS_EXPORT_CSV: a record is a row per metric, under the header
+ *   node,role,time,final,metric,value
+ *
+ * The first DSL core creates (truncates) the file before the init barrier;
+ * the records of a core are written with a single write on the file opened
+ * with O_APPEND, thus they are not interleaved. The hashtable is only
+ * traversed for the final record of a DSL core.
+ */
+
+#ifndef _TM2C_STATS_H_
+#define _TM2C_STATS_H_
+
+#include <stdint.h>
+
+#define STATS_EXPORT_JSON 1
+#define STATS_EXPORT_CSV  2
+
+#if defined(STATS_EXPORT)
+
+#  if !defined(STATS_EXPORT_FILE)
+#    define STATS_EXPORT_FILE "tm2c_stats.out"
+#  endif
+#  if !defined(STATS_EXPORT_PERIOD)
+#    define STATS_EXPORT_PERIOD 0 /* seconds, 0: only at the end */
+#  endif
+
+#define TM2C_STATS_REQ_TYPES 32	/* >= TM2C_RPC_UKNOWN + 1, power of 2 */
+
+extern uint64_t tm2c_stats_msgs_sent;
+extern uint64_t tm2c_stats_msgs_recv;
+extern uint64_t tm2c_stats_requests[TM2C_STATS_REQ_TYPES]; /* dsl: per type */
+
+#  define TM2C_STATS_SENT(num)   tm2c_stats_msgs_sent += (num)
+#  define TM2C_STATS_RECV(num)   tm2c_stats_msgs_recv += (num)
+#  define TM2C_STATS_REQ(type)					\
+  tm2c_stats_requests[(type) & (TM2C_STATS_REQ_TYPES - 1)]++
+
+struct tm2c_tx_node;
+
+/* first dsl core, before the init barrier */
+extern void tm2c_stats_create();
+/* every core: opens the file and starts the sampling thread */
+extern void tm2c_stats_init();
+
+/* the final records */
+extern void tm2c_stats_app(struct tm2c_tx_node* stats, double duration);
+extern void tm2c_stats_dsl();
+
+/* fields of the record being written, for the modules that export theirs */
+extern void tm2c_stats_u64(const char* name, uint64_t value);
+extern void tm2c_stats_f64(const char* name, double value);
+
+#else  /* !STATS_EXPORT */
+
+#  define TM2C_STATS_SENT(num)
+#  define TM2C_STATS_RECV(num)
+#  define TM2C_STATS_REQ(type)
+
+#endif	/* STATS_EXPORT */
+
+#endif	/* _TM2C_STATS_H_ */
@@ -51,10 +51,31 @@ extern "C" {
       COMMITTED
     } TX_STATE;
 
+#if defined(TX_NESTING)
+#  if !defined(TX_NESTING_MAX)
+#    define TX_NESTING_MAX 8	/* nested blocks with a savepoint */
+#  endif
+#  if !defined(TX_NESTING_RETRIES)
+#    define TX_NESTING_RETRIES 4
+#  endif
+
+  typedef struct tm2c_tx_savepoint /* The start of a nested block */
+  {
+    sigjmp_buf env;		/* Restarts the block */
+    uint32_t retries;		/* Rollbacks of the block */
+#  if !defined(PGAS)
+    uint32_t ws_entries;	/* Write set entries of the enclosing blocks */
+    uint32_t ws_blocks_used;
+#  endif
+    mem_info_t mem_info;	/* Heads of the mem alloc lists */
+    unsigned short* contacted;	/* The nodes_contacted of the enclosing blocks */
+  } tm2c_tx_savepoint_t;
+#endif	/* TX_NESTING */
+
   typedef struct ALIGNED(64) tm2c_tx /* Transaction descriptor */
   { 
     sigjmp_buf env;		/* Environment for setjmp/longjmp */
-#if defined(GREEDY) | defined(FAIRCM) /* placed in diff place than for FAIRCM, according to access seq */
+#if defined(GREEDY) | defined(FAIRCM) | defined(DYNAMIC_CM) /* placed in diff place than for FAIRCM, according to access seq */
     ticks start_ts;
 #endif
     uint32_t aborts;	 /* Total number of aborts (cumulative) */
@@ -65,6 +86,23 @@ extern "C" {
     mem_info_t* mem_info; /* Transactional mem alloc lists*/
 #if !defined(PGAS)		/* in PGAS only the DSLs hold a write_set */
     tm2c_write_set_t *write_set;	/* Write set */
+#endif
+#if defined(PGAS_MVCC)
+    uint64_t snapshot;		/* of a read-only tx (0 for an update tx) */
+#endif
+#if defined(IRREVOCABLE)
+    uint32_t irrevocable;	/* holds the irrevocability token */
+#endif
+#if defined(TX_NESTING)
+    uint32_t nesting;		/* Depth of the current block (0: no tx) */
+    tm2c_tx_savepoint_t* savepoints; /* Of the blocks at depths 2 .. TX_NESTING_MAX + 1 */
+#endif
+#if defined(TX_PROFILE)
+    const char* site_file;	/* TX_START of the current tx */
+    uint32_t site_line;
+#endif
+#if defined(TX_HISTO)
+    ticks histo_start;		/* first TX_START of the current tx */
 #endif
   } tm2c_tx_t;
 
@@ -77,7 +115,7 @@ extern "C" {
     uint32_t aborts_war;
     uint32_t aborts_raw;
     uint32_t aborts_waw;
-#ifdef FAIRCM
+#if defined(FAIRCM) || defined(DYNAMIC_CM)
     ticks tx_duration;
 #else
     uint8_t padding[36];
@@ -96,6 +134,9 @@ extern "C" {
 
 #if !defined(PGAS)
     tm2c_tx_temp->write_set = write_set_empty(tm2c_tx_temp->write_set);
+#endif
+#if defined(PGAS_MVCC)
+    tm2c_tx_temp->snapshot = 0;
 #endif
     //tm2c_tx_temp->mem_info = mem_info_new();
     //TODO: what about the env?
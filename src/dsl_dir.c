@@ -0,0 +1,199 @@
+/*
+ *   File: dsl_dir.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: directory-based address to DSL node mapping with
+ *                online rebalancing (ADDR_TO_DSL_SEL = 2)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "dsl_dir.h"
+
+#if (ADDR_TO_DSL_SEL == 2)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+dsl_dir_t* dsl_dir;
+
+#define DSL_DIR_KEY        "/tm2c_dsl_dir"
+#define DSL_DIR_PERIOD     ((ticks) (DSL_DIR_PERIOD_MS * REF_SPEED_GHZ * 1e6))
+
+/* called by every node before the init barrier */
+void
+dsl_dir_init(nodeid_t num_nodes)
+{
+  size_t size = sizeof(dsl_dir_t) + TOTAL_NODES() * sizeof(dsl_dir_app_t);
+
+  int fd = shm_open(DSL_DIR_KEY, O_CREAT | O_RDWR, S_IRWXU | S_IRWXG);
+  if (fd < 0)
+    {
+      perror("In shm_open");
+      exit(1);
+    }
+
+  if (ftruncate(fd, size))
+    {
+      printf("ftruncate");
+    }
+
+  dsl_dir = (dsl_dir_t*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  assert(dsl_dir != MAP_FAILED);
+
+  /* also if it already exists: might be left over from another run */
+  if (NODE_ID() == 0)
+    {
+      memset((void*) dsl_dir, 0, size);
+      dsl_dir->num_nodes = num_nodes;
+      dsl_dir->next = getticks() + DSL_DIR_PERIOD;
+
+      uint32_t r;
+      for (r = 0; r < DSL_DIR_SIZE; r++)
+	{
+	  dsl_dir->node[r] = r % num_nodes;
+	}
+    }
+}
+
+void
+dsl_dir_term()
+{
+  if (NODE_ID() == 0 && dsl_dir->rebalances > 0)
+    {
+      printf("DSL directory: %u rebalancings, %u regions moved\n", dsl_dir->rebalances, dsl_dir->moves);
+    }
+  shm_unlink(DSL_DIR_KEY);
+}
+
+/* plans up to DSL_DIR_MAX_MOVES moves of regions from the most to the least
+   loaded node: the most loaded region that decreases the difference of the
+   two. Returns the number of moves */
+static uint32_t
+dsl_dir_plan(uint64_t* node_load, uint32_t* region, nodeid_t* to)
+{
+  uint32_t m, r, n;
+  for (m = 0; m < DSL_DIR_MAX_MOVES; m++)
+    {
+      nodeid_t hi = 0, lo = 0;
+      for (n = 1; n < dsl_dir->num_nodes; n++)
+	{
+	  if (node_load[n] > node_load[hi])
+	    {
+	      hi = n;
+	    }
+	  if (node_load[n] < node_load[lo])
+	    {
+	      lo = n;
+	    }
+	}
+
+      uint64_t gap = node_load[hi] - node_load[lo];
+      if (gap * 8 < node_load[hi])	/* within 12.5% */
+	{
+	  break;
+	}
+
+      int32_t best = -1;
+      for (r = 0; r < DSL_DIR_SIZE; r++)
+	{
+	  if (dsl_dir->node[r] == hi && dsl_dir->load[r] < gap &&
+	      (best < 0 || dsl_dir->load[r] > dsl_dir->load[best]))
+	    {
+	      best = r;
+	    }
+	}
+
+      if (best < 0 || dsl_dir->load[best] == 0)
+	{
+	  break;
+	}
+
+      /* not planned again; it restarts counting on its new node */
+      region[m] = best;
+      to[m] = lo;
+      node_load[hi] -= dsl_dir->load[best];
+      node_load[lo] += dsl_dir->load[best];
+      dsl_dir->load[best] = 0;
+    }
+  return m;
+}
+
+void
+dsl_dir_rebalance()
+{
+  if (!__sync_bool_compare_and_swap(&dsl_dir->lock, 0, 1))
+    {
+      return;
+    }
+  if (getticks() < dsl_dir->next)
+    {
+      dsl_dir->lock = 0;
+      return;
+    }
+
+  uint64_t* node_load = (uint64_t*) calloc(dsl_dir->num_nodes, sizeof(uint64_t));
+  assert(node_load != NULL);
+
+  uint32_t r;
+  for (r = 0; r < DSL_DIR_SIZE; r++)
+    {
+      node_load[dsl_dir->node[r]] += dsl_dir->load[r];
+    }
+
+  uint32_t region[DSL_DIR_MAX_MOVES];
+  nodeid_t to[DSL_DIR_MAX_MOVES];
+  uint32_t m, moves = dsl_dir_plan(node_load, region, to);
+  free(node_load);
+
+  /* the transactions are frozen only if some region moves */
+  if (moves > 0)
+    {
+      dsl_dir->freeze = 1;
+      __sync_synchronize();
+
+      nodeid_t n;
+      for (n = 0; n < TOTAL_NODES(); n++)
+	{
+	  while (dsl_dir->app[n].in_tx)
+	    {
+	      wait_cycles(64);
+	    }
+	}
+
+      for (m = 0; m < moves; m++)
+	{
+	  dsl_dir->node[region[m]] = to[m];
+	}
+      dsl_dir->moves += moves;
+    }
+
+  for (r = 0; r < DSL_DIR_SIZE; r++)
+    {
+      dsl_dir->load[r] >>= 1;
+    }
+
+  dsl_dir->rebalances++;
+  dsl_dir->next = getticks() + DSL_DIR_PERIOD;
+  __sync_synchronize();
+  dsl_dir->freeze = 0;
+  dsl_dir->lock = 0;
+}
+
+#endif	/* ADDR_TO_DSL_SEL == 2 */
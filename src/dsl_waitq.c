@@ -0,0 +1,185 @@
+/*
+ *   File: dsl_waitq.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: DSL-side wait queue for the requests that conflict on
+ *                hot addresses (DSL_WAITQ)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "dsl_waitq.h"
+
+#if defined(DSL_WAITQ)
+
+#include "tm2c_dsl.h"
+#include "hash.h"
+
+typedef struct dsl_waitq_entry
+{
+  TM2C_RPC_REQ req;
+  ticks deadline;
+  uint32_t gen;			/* of the last try */
+} dsl_waitq_entry_t;
+
+typedef struct dsl_waitq_hot
+{
+  tm_intern_addr_t address;
+  uint32_t conflicts;
+} dsl_waitq_hot_t;
+
+static dsl_waitq_entry_t* waiters; /* per sender: one request at a time */
+static nodeid_t* waiting;	   /* the senders, in FIFO order */
+static uint32_t num_waiting = 0;
+static uint32_t gen = 0;	/* increased for every received request */
+static int32_t retrying = -1;	/* the index in waiting of the retried one */
+static uint32_t retry_kept;	/* the retried one was queued again */
+static dsl_waitq_hot_t hot[DSL_WAITQ_HOT_SIZE];
+
+static uint32_t stats_waits = 0, stats_timeouts = 0;
+#if defined(STATS_EXPORT)
+static uint32_t stats_max_waiting = 0;
+#endif
+
+void
+dsl_waitq_init()
+{
+  waiters = (dsl_waitq_entry_t*) calloc(NUM_UES, sizeof(dsl_waitq_entry_t));
+  waiting = (nodeid_t*) malloc(NUM_UES * sizeof(nodeid_t));
+  assert(waiters != NULL && waiting != NULL);
+}
+
+void
+dsl_waitq_term()
+{
+  if (stats_waits > 0)
+    {
+      printf("[%02d] DSL wait queue: %u waits, %u timeouts\n", NODE_ID(), stats_waits, stats_timeouts);
+    }
+  free(waiters);
+  free(waiting);
+}
+
+/* counts a conflict on address. Returns TRUE if it is hot. The counts of
+   two addresses that map to the same slot cancel out */
+static inline uint32_t
+dsl_waitq_hot(tm_intern_addr_t address)
+{
+  dsl_waitq_hot_t* h = hot + (hash_tw(address >> 3) & (DSL_WAITQ_HOT_SIZE - 1));
+  if (h->address == address)
+    {
+      if (h->conflicts < DSL_WAITQ_HOT)
+	{
+	  h->conflicts++;
+	}
+    }
+  else if (h->conflicts == 0)
+    {
+      h->address = address;
+      h->conflicts = 1;
+    }
+  else
+    {
+      h->conflicts--;
+    }
+
+  return (h->address == address && h->conflicts >= DSL_WAITQ_HOT);
+}
+
+uint32_t
+dsl_waitq_defer(nodeid_t sender, TM2C_RPC_REQ* req)
+{
+  dsl_waitq_entry_t* w = waiters + sender;
+  if (retrying >= 0 && waiting[retrying] == sender)
+    {
+      if (getticks() > w->deadline || !tm2c_ht_holders_below(tm2c_ht, sender, req->address))
+	{
+	  stats_timeouts += (getticks() > w->deadline);
+	  return FALSE;
+	}
+      retry_kept = 1;
+      return TRUE;
+    }
+
+  if (!dsl_waitq_hot(req->address) || !tm2c_ht_holders_below(tm2c_ht, sender, req->address))
+    {
+      return FALSE;
+    }
+
+  assert(num_waiting < NUM_UES);
+  w->req = *req;
+  w->deadline = getticks() + DSL_WAITQ_TIMEOUT;
+  w->gen = gen;
+  waiting[num_waiting++] = sender;
+  stats_waits++;
+#if defined(STATS_EXPORT)
+  if (num_waiting > stats_max_waiting)
+    {
+      stats_max_waiting = num_waiting;
+    }
+#endif
+  return TRUE;
+}
+
+uint32_t
+dsl_waitq_retry(TM2C_RPC_REQ* req, nodeid_t* sender)
+{
+  uint32_t i;
+  if (retrying >= 0)
+    {
+      /* answered: either succeeded or aborted */
+      if (!retry_kept)
+	{
+	  num_waiting--;
+	  for (i = retrying; i < num_waiting; i++)
+	    {
+	      waiting[i] = waiting[i + 1];
+	    }
+	}
+      retrying = -1;
+    }
+
+  for (i = 0; i < num_waiting; i++)
+    {
+      dsl_waitq_entry_t* w = waiters + waiting[i];
+      if (w->gen != gen)
+	{
+	  w->gen = gen;
+	  retrying = i;
+	  retry_kept = 0;
+	  *req = w->req;
+	  *sender = waiting[i];
+	  return TRUE;
+	}
+    }
+
+  gen++;			/* for the request that is about to be received */
+  return FALSE;
+}
+
+#if defined(STATS_EXPORT)
+void
+dsl_waitq_stats_export()
+{
+  tm2c_stats_u64("waitq.waiting", num_waiting);
+  tm2c_stats_u64("waitq.max_waiting", stats_max_waiting);
+  tm2c_stats_u64("waitq.waits", stats_waits);
+  tm2c_stats_u64("waitq.timeouts", stats_timeouts);
+}
+#endif	/* STATS_EXPORT */
+
+#endif	/* DSL_WAITQ */
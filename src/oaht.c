@@ -0,0 +1,328 @@
+/*
+ *   File: oaht.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: open-addressing, resizable hashtable for the DSL service
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "oaht.h"
+
+#include <malloc.h>
+
+#define OAHT_HASH(addr)      hash_tw((uint32_t) ((addr) >> 2))
+#define OAHT_CAPACITY(t)     ((t)->num_groups * OAHT_GROUP_SLOTS)
+#define OAHT_MAX_USED(t)     (3 * OAHT_CAPACITY(t) / 4)
+#define OAHT_IS_KEY(a)       ((a) != OAHT_EMPTY && (a) != OAHT_TOMBSTONE)
+
+static void
+oaht_table_init(oaht_table_t* t, uint32_t num_groups)
+{
+  t->groups = (oaht_group_t*) memalign(CACHE_LINE_SIZE, num_groups * sizeof(oaht_group_t));
+  assert(t->groups != NULL);
+  memset(t->groups, 0, num_groups * sizeof(oaht_group_t));
+  t->num_groups = num_groups;
+  t->live = 0;
+  t->tombstones = 0;
+}
+
+/* returns the group of addr in t and the slot in *s (NULL if not in t) */
+static inline oaht_group_t*
+oaht_table_find(oaht_table_t* t, uintptr_t addr, uint32_t* s)
+{
+  uint32_t mask = t->num_groups - 1;
+  uint32_t g = OAHT_HASH(addr) & mask;
+  uint32_t n;
+  for (n = 0; n < t->num_groups; n++)
+    {
+      oaht_group_t* gr = t->groups + g;
+      uint32_t i, has_empty = 0;
+      for (i = 0; i < OAHT_GROUP_SLOTS; i++)
+	{
+	  if (gr->addr[i] == addr)
+	    {
+	      *s = i;
+	      return gr;
+	    }
+	  has_empty |= (gr->addr[i] == OAHT_EMPTY);
+	}
+
+      if (has_empty)		/* end of the probe sequence */
+	{
+	  break;
+	}
+      g = (g + 1) & mask;
+    }
+
+  return NULL;
+}
+
+/* addr must not be in t */
+static inline void
+oaht_table_place(oaht_table_t* t, uintptr_t addr, oaht_rec_t* rec)
+{
+  uint32_t mask = t->num_groups - 1;
+  uint32_t g = OAHT_HASH(addr) & mask;
+  while (1)
+    {
+      oaht_group_t* gr = t->groups + g;
+      uint32_t i;
+      for (i = 0; i < OAHT_GROUP_SLOTS; i++)
+	{
+	  if (!OAHT_IS_KEY(gr->addr[i]))
+	    {
+	      if (gr->addr[i] == OAHT_TOMBSTONE)
+		{
+		  t->tombstones--;
+		}
+	      gr->addr[i] = addr;
+	      gr->rec[i] = rec;
+	      t->live++;
+	      return;
+	    }
+	}
+      g = (g + 1) & mask;
+    }
+}
+
+/* moves the next OAHT_MIGRATE_STEP groups of the old table to the current */
+static void
+oaht_migrate(oaht_hashtable_t ht, uint32_t step)
+{
+  oaht_table_t* old = &ht->old;
+  while (step-- > 0 && ht->migrate_next < old->num_groups)
+    {
+      oaht_group_t* gr = old->groups + ht->migrate_next++;
+      uint32_t i;
+      for (i = 0; i < OAHT_GROUP_SLOTS; i++)
+	{
+	  if (OAHT_IS_KEY(gr->addr[i]))
+	    {
+	      oaht_table_place(&ht->cur, gr->addr[i], gr->rec[i]);
+	      /* keep the probe sequences of the old table valid */
+	      gr->addr[i] = OAHT_TOMBSTONE;
+	      old->live--;
+	    }
+	}
+    }
+
+  if (ht->migrate_next == old->num_groups)
+    {
+      free(old->groups);
+      old->groups = NULL;
+    }
+}
+
+static void
+oaht_resize(oaht_hashtable_t ht)
+{
+  if (ht->old.groups != NULL)
+    {
+      oaht_migrate(ht, ht->old.num_groups);
+    }
+
+  oaht_table_t* cur = &ht->cur;
+  uint32_t num_groups = cur->num_groups;
+  if (cur->live > OAHT_CAPACITY(cur) / 2)
+    {
+      num_groups *= 2;
+    }
+  else if (cur->live < OAHT_CAPACITY(cur) / 8 && num_groups > OAHT_INIT_GROUPS)
+    {
+      num_groups /= 2;
+    }
+
+  ht->old = *cur;
+  ht->migrate_next = 0;
+  oaht_table_init(cur, num_groups);
+  ht->resizes++;
+}
+
+static oaht_rec_t*
+oaht_rec_new(oaht_hashtable_t ht)
+{
+  if (ht->free_recs == NULL)
+    {
+      if (ht->num_chunks == ht->size_chunks)
+	{
+	  ht->size_chunks = (ht->size_chunks == 0) ? 8 : 2 * ht->size_chunks;
+	  ht->chunks = (oaht_rec_t**) realloc(ht->chunks, ht->size_chunks * sizeof(oaht_rec_t*));
+	  assert(ht->chunks != NULL);
+	}
+
+      oaht_rec_t* chunk = (oaht_rec_t*) memalign(CACHE_LINE_SIZE, OAHT_REC_CHUNK * sizeof(oaht_rec_t));
+      assert(chunk != NULL);
+      memset(chunk, 0, OAHT_REC_CHUNK * sizeof(oaht_rec_t));
+      ht->chunks[ht->num_chunks++] = chunk;
+
+      uint32_t i;
+      for (i = 0; i < OAHT_REC_CHUNK; i++)
+	{
+	  chunk[i].entry.writer = SSHT_NO_WRITER;
+	  chunk[i].next_free = ht->free_recs;
+	  ht->free_recs = chunk + i;
+	}
+    }
+
+  oaht_rec_t* rec = ht->free_recs;
+  ht->free_recs = rec->next_free;
+  return rec;
+}
+
+oaht_hashtable_t
+oaht_new()
+{
+  oaht_hashtable_t ht = (oaht_hashtable_t) calloc(1, sizeof(oaht_t));
+  assert(ht != NULL);
+  assert((OAHT_INIT_GROUPS & (OAHT_INIT_GROUPS - 1)) == 0);
+  assert(sizeof(oaht_group_t) % CACHE_LINE_SIZE == 0);
+
+  oaht_table_init(&ht->cur, OAHT_INIT_GROUPS);
+  return ht;
+}
+
+void
+oaht_free(oaht_hashtable_t ht)
+{
+  uint32_t i;
+  for (i = 0; i < ht->num_chunks; i++)
+    {
+      free(ht->chunks[i]);
+    }
+  free(ht->chunks);
+  free(ht->old.groups);
+  free(ht->cur.groups);
+  free(ht);
+}
+
+static inline oaht_rec_t*
+oaht_find(oaht_hashtable_t ht, uintptr_t addr)
+{
+  uint32_t s;
+  oaht_group_t* gr = oaht_table_find(&ht->cur, addr, &s);
+  if (gr == NULL && ht->old.groups != NULL)
+    {
+      gr = oaht_table_find(&ht->old, addr, &s);
+    }
+  return (gr != NULL) ? gr->rec[s] : NULL;
+}
+
+ssht_rw_entry_t*
+oaht_lookup(oaht_hashtable_t ht, uintptr_t addr)
+{
+  oaht_rec_t* rec = oaht_find(ht, addr);
+  return (rec != NULL) ? &rec->entry : NULL;
+}
+
+TM2C_CONFLICT_T
+oaht_insert(oaht_hashtable_t ht, ssht_log_set_t* log, uint32_t id, uintptr_t addr, RW rw)
+{
+  if (ht->old.groups != NULL)
+    {
+      oaht_migrate(ht, OAHT_MIGRATE_STEP);
+    }
+
+  oaht_rec_t* rec = oaht_find(ht, addr);
+  if (rec == NULL)
+    {
+      if (ht->cur.live + ht->cur.tombstones >= OAHT_MAX_USED(&ht->cur))
+	{
+	  oaht_resize(ht);
+	}
+      rec = oaht_rec_new(ht);
+      rec->addr = addr;
+      oaht_table_place(&ht->cur, addr, rec);
+    }
+
+  /* the contention manager might remove all the users of rec */
+  ht->pinned = rec;
+  TM2C_CONFLICT_T conflict;
+  if (rw == READ)
+    {
+      conflict = ssht_rw_entry_insert_r(&rec->entry, &rec->addr, addr, log, id);
+    }
+  else
+    {
+      conflict = ssht_rw_entry_insert_w(&rec->entry, &rec->addr, addr, log, id);
+    }
+  ht->pinned = NULL;
+
+  if (ssht_rw_entry_is_free(&rec->entry))
+    {
+      oaht_release(ht, &rec->entry);
+    }
+
+  return conflict;
+}
+
+void
+oaht_release(oaht_hashtable_t ht, ssht_rw_entry_t* entry)
+{
+  oaht_rec_t* rec = (oaht_rec_t*) entry;
+  if (rec == ht->pinned)
+    {
+      return;
+    }
+
+  uint32_t s;
+  oaht_table_t* t = &ht->cur;
+  oaht_group_t* gr = oaht_table_find(t, rec->addr, &s);
+  if (gr == NULL && ht->old.groups != NULL)
+    {
+      t = &ht->old;
+      gr = oaht_table_find(t, rec->addr, &s);
+    }
+  assert(gr != NULL && gr->rec[s] == rec);
+
+  gr->addr[s] = OAHT_TOMBSTONE;
+  t->live--;
+  t->tombstones++;
+
+  rec->next_free = ht->free_recs;
+  ht->free_recs = rec;
+}
+
+void
+oaht_stats_print(oaht_hashtable_t ht, uint32_t details)
+{
+#if defined(SSHT_DBG_UTILIZATION)
+  printf("OAHT stats: core %02d  /  ", NODE_ID());
+  printf("groups: %-8u  /  live: %-8u  /  tombstones: %-8u  /  resizes: %-4u  /  records: %u\n",
+	 ht->cur.num_groups, ht->cur.live, ht->cur.tombstones, ht->resizes, ht->num_chunks * OAHT_REC_CHUNK);
+  if (details)
+    {
+      uint32_t g, hist[OAHT_GROUP_SLOTS + 1] = {0};
+      for (g = 0; g < ht->cur.num_groups; g++)
+	{
+	  uint32_t i, n = 0;
+	  for (i = 0; i < OAHT_GROUP_SLOTS; i++)
+	    {
+	      n += OAHT_IS_KEY(ht->cur.groups[g].addr[i]);
+	    }
+	  hist[n]++;
+	}
+      printf(" groups per #live slots:");
+      for (g = 0; g <= OAHT_GROUP_SLOTS; g++)
+	{
+	  printf(" %u:%-6u", g, hist[g]);
+	}
+      printf("\n");
+    }
+#endif	/* SSHT_DBG_UTILIZATION */
+}
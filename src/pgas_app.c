@@ -22,6 +22,9 @@
  *
  */
 #include "pgas_app.h"
+#if defined(PGAS_MVCC)
+#  include "pgas_mvcc.h"
+#endif	/* PGAS_MVCC */
 
 nodeid_t pgas_app_my_resp_node;
 nodeid_t pgas_app_my_resp_node_real;
@@ -106,12 +109,19 @@ pgas_app_init()
   PRINTD(" **  Sending to %3d (realid: %02d) :: off: %10lu :: shared by %2d (my seq %d)", 
 	pgas_app_my_resp_node, real_id, (UL) pgas_app_addr_offs(pgas_app_mem_mine), 
 	 num_app_sharing, my_seq_sharing);
+
+#if defined(PGAS_MVCC)
+  pgas_mvcc_init();
+#endif	/* PGAS_MVCC */
 }
 
 void
 pgas_app_term()
 {
   free(pgas_allocs);
+#if defined(PGAS_MVCC)
+  pgas_mvcc_term();
+#endif	/* PGAS_MVCC */
 }
 
 void*
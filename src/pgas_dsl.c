@@ -22,6 +22,9 @@
  *
  */
 #include "pgas_dsl.h"
+#if defined(PGAS_MVCC)
+#  include "pgas_mvcc.h"
+#endif	/* PGAS_MVCC */
 
 static volatile void* pgas_dsl_mem;
 #define PTR_ADD(ptr, plus) ((char*) (ptr) + (plus))
@@ -33,12 +36,18 @@ pgas_dsl_init()
   assert(pgas_dsl_mem != NULL);
   PRINTD(" <><> allocated %ld B = %ld KiB = %ld MiB for pgas mem", 
 	PGAS_DSL_SIZE_NODE, PGAS_DSL_SIZE_NODE / 1024, PGAS_DSL_SIZE_NODE / (1024 * 1024));
+#if defined(PGAS_MVCC)
+  pgas_mvcc_init();
+#endif	/* PGAS_MVCC */
 }
 
 void
 pgas_dsl_term()
 {
   free((void*) pgas_dsl_mem);
+#if defined(PGAS_MVCC)
+  pgas_mvcc_term();
+#endif	/* PGAS_MVCC */
 }
 
 inline int64_t
@@ -0,0 +1,235 @@
+/*
+ *   File: pgas_mvcc.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: multi-version snapshot reads for PGAS
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "pgas_mvcc.h"
+
+#if defined(PGAS_MVCC)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+
+pgas_mvcc_shmem_t* pgas_mvcc_shmem;
+
+#define PGAS_MVCC_KEY          "/tm2c_pgas_mvcc"
+#define PGAS_MVCC_BUCKETS      (1 << 16)
+#define PGAS_MVCC_HASH(offset) (((offset) >> 2) & (PGAS_MVCC_BUCKETS - 1))
+
+typedef struct pgas_mvcc_version
+{
+  uint64_t ts;
+  int64_t value;
+} pgas_mvcc_version_t;
+
+/* the history of a word: allocated the first time the word is persisted */
+typedef struct pgas_mvcc_rec
+{
+  uint64_t offset;
+  uint64_t ts;			/* of the current value (in the pgas mem) */
+  uint32_t nb;
+  uint32_t next;		/* versions is a ring */
+  pgas_mvcc_version_t versions[PGAS_MVCC_VERSIONS];
+  struct pgas_mvcc_rec* chain;
+} pgas_mvcc_rec_t;
+
+static pgas_mvcc_rec_t** pgas_mvcc_recs = NULL;
+
+void
+pgas_mvcc_init()
+{
+  size_t size = sizeof(pgas_mvcc_shmem_t) + TOTAL_NODES() * sizeof(uint64_t);
+  uint32_t created = 1;
+
+  int fd = shm_open(PGAS_MVCC_KEY, O_CREAT | O_EXCL | O_RDWR, S_IRWXU | S_IRWXG);
+  if (fd < 0)
+    {
+      if (errno != EEXIST)
+	{
+	  perror("In shm_open");
+	  exit(1);
+	}
+
+      created = 0;
+      fd = shm_open(PGAS_MVCC_KEY, O_CREAT | O_RDWR, S_IRWXU | S_IRWXG);
+      if (fd < 0)
+	{
+	  perror("In shm_open");
+	  exit(1);
+	}
+    }
+
+  /* also if it already exists: might be left over from a smaller run */
+  if (ftruncate(fd, size))
+    {
+      printf("ftruncate");
+    }
+
+  pgas_mvcc_shmem = (pgas_mvcc_shmem_t*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  assert(pgas_mvcc_shmem != MAP_FAILED);
+
+  /* the initial versions have ts 0, so they are in every snapshot */
+  if (created)
+    {
+      __sync_val_compare_and_swap(&pgas_mvcc_shmem->clock, 0, 1);
+    }
+  pgas_mvcc_shmem->commit_ts[NODE_ID()] = PGAS_MVCC_IDLE;
+}
+
+void
+pgas_mvcc_term()
+{
+  shm_unlink(PGAS_MVCC_KEY);
+
+  if (pgas_mvcc_recs != NULL)
+    {
+      uint32_t b;
+      for (b = 0; b < PGAS_MVCC_BUCKETS; b++)
+	{
+	  pgas_mvcc_rec_t* rec = pgas_mvcc_recs[b];
+	  while (rec != NULL)
+	    {
+	      pgas_mvcc_rec_t* chain = rec->chain;
+	      free(rec);
+	      rec = chain;
+	    }
+	}
+      free(pgas_mvcc_recs);
+      pgas_mvcc_recs = NULL;
+    }
+}
+
+static inline pgas_mvcc_rec_t*
+pgas_mvcc_lookup(uint64_t offset)
+{
+  if (pgas_mvcc_recs == NULL)
+    {
+      return NULL;
+    }
+
+  pgas_mvcc_rec_t* rec = pgas_mvcc_recs[PGAS_MVCC_HASH(offset)];
+  while (rec != NULL && rec->offset != offset)
+    {
+      rec = rec->chain;
+    }
+  return rec;
+}
+
+static void
+pgas_mvcc_write_ts(uint64_t offset, int64_t val, uint64_t ts)
+{
+  pgas_mvcc_rec_t* rec = pgas_mvcc_lookup(offset);
+  if (rec == NULL)
+    {
+      if (pgas_mvcc_recs == NULL)
+	{
+	  pgas_mvcc_recs = (pgas_mvcc_rec_t**) calloc(PGAS_MVCC_BUCKETS, sizeof(pgas_mvcc_rec_t*));
+	  assert(pgas_mvcc_recs != NULL);
+	}
+
+      rec = (pgas_mvcc_rec_t*) calloc(1, sizeof(pgas_mvcc_rec_t));
+      assert(rec != NULL);
+      rec->offset = offset;
+      rec->chain = pgas_mvcc_recs[PGAS_MVCC_HASH(offset)];
+      pgas_mvcc_recs[PGAS_MVCC_HASH(offset)] = rec;
+    }
+
+  rec->versions[rec->next].ts = rec->ts;
+  rec->versions[rec->next].value = pgas_dsl_read(offset);
+  rec->next = (rec->next + 1) % PGAS_MVCC_VERSIONS;
+  if (rec->nb < PGAS_MVCC_VERSIONS)
+    {
+      rec->nb++;
+    }
+
+  rec->ts = ts;
+  pgas_dsl_write(offset, val);
+}
+
+void
+pgas_mvcc_write(uint64_t offset, int64_t val, nodeid_t writer)
+{
+  /* the write lock of the word is held until the writer is persisted, thus
+     the timestamps of a word are increasing */
+  pgas_mvcc_write_ts(offset, val, pgas_mvcc_shmem->commit_ts[writer]);
+}
+
+void
+pgas_mvcc_write_nontx(uint64_t offset, int64_t val)
+{
+  /* the snapshot reads of the word are served by this node, thus none of
+     them sees the clock advanced but the word not yet written */
+  pgas_mvcc_write_ts(offset, val, __sync_add_and_fetch(&pgas_mvcc_shmem->clock, 1));
+}
+
+TM2C_CONFLICT_T
+pgas_mvcc_read(uint64_t offset, uint64_t packed, int32_t writer, int64_t* val)
+{
+  uint64_t snapshot = PGAS_MVCC_SNAPSHOT(packed);
+
+  /* the writer might persist a version within the snapshot */
+  if (writer >= 0)
+    {
+      uint64_t commit_ts = pgas_mvcc_shmem->commit_ts[writer];
+      if (commit_ts == PGAS_MVCC_PENDING ||
+	  (commit_ts != PGAS_MVCC_IDLE && commit_ts <= snapshot))
+	{
+	  return READ_AFTER_WRITE;
+	}
+    }
+
+  int64_t value;
+  pgas_mvcc_rec_t* rec = pgas_mvcc_lookup(offset);
+  if (rec == NULL || rec->ts <= snapshot)
+    {
+      value = pgas_dsl_read(offset);
+    }
+  else
+    {
+      uint32_t i, idx = rec->next;
+      for (i = 0; i < rec->nb; i++)
+	{
+	  idx = (idx == 0) ? PGAS_MVCC_VERSIONS - 1 : idx - 1;
+	  if (rec->versions[idx].ts <= snapshot)
+	    {
+	      break;
+	    }
+	}
+
+      if (i == rec->nb)	/* evicted */
+	{
+	  return READ_AFTER_WRITE;
+	}
+      value = rec->versions[idx].value;
+    }
+
+  if (PGAS_MVCC_WORDS(packed) == 1)
+    {
+      value = (int32_t) value;
+    }
+  *val = value;
+  return NO_CONFLICT;
+}
+
+#endif	/* PGAS_MVCC */
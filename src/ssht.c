@@ -59,6 +59,7 @@ ssht_new()
       for (j = 0; j < ENTRY_PER_CL; j++) 
 	{
 	  hashtable[i].entry[j].writer = SSHT_NO_WRITER;
+	  hashtable[i].entry[j].idx = j;
 	}
     }
 
@@ -81,7 +82,7 @@ bucket_print(bucket_t* bu)
       uint32_t j;
       for (j = 0; j < ADDR_PER_CL; j++) 
 	{
-	  printf("%p:%2d/%d|", (void*)btmp->addr[j], btmp->entry[j].nr, btmp->entry[j].writer);
+	  printf("%p:%2d/%d|", (void*)btmp->addr[j], btmp->entry[j].readers.nr, btmp->entry[j].writer);
 	}
       btmp = btmp->next;
       printf("|");
@@ -92,178 +93,113 @@ bucket_print(bucket_t* bu)
 }
 
 
-TM2C_CONFLICT_T 
-bucket_insert_r(bucket_t* bu, ssht_log_set_t* log, uint32_t id, uintptr_t addr) 
+/* 
+ * One pass over the chain of bu, one tag probe per bucket: returns the
+ * bucket that holds addr, or else the one with the first free slot of the
+ * chain, appending a new bucket if there is none. The index is in *i.
+ */
+static inline bucket_t*
+bucket_probe(bucket_t* bu, uintptr_t addr, uint8_t tag, uint32_t* i)
 {
-  uint32_t i;
+  bucket_t* bfree = NULL;
+  uint32_t ifree = 0;
   bucket_t* btmp = bu;
-  do 
+  while (1)
     {
-      for (i = 0; i < ADDR_PER_CL; i++) 
+      uint32_t empty;
+      uint32_t match = tag_probe(btmp->tag, tag, &empty) & SSHT_TAG_VALID;
+      while (match)
 	{
-	  if (btmp->addr[i] == addr) 
+	  uint32_t m = tag_probe_first(match);
+	  if (btmp->addr[m] == addr)
 	    {
-	      ssht_rw_entry_t* e = btmp->entry + i;
-	      if (e->writer != SSHT_NO_WRITER) 
-		{
-#if !defined(NOCM) && !defined(BACKOFF_RETRY) 			/* if any other CM (greedy, wholly, faircm) */
-		  if (!contention_manager_raw_waw(id, (uint16_t) e->writer, READ_AFTER_WRITE)) 
-		    {
-		      return READ_AFTER_WRITE;
-		    }
-#else
-		  return READ_AFTER_WRITE;
-#endif	/* NOCM */
-		}
-
-	      btmp->addr[i] = addr;
-#if defined(BIT_OPTS)
-	      rw_entry_ssht_set(e, id);
-	      ssht_log_set_insert(log, btmp->addr + i, e);
-#else
-	      if (!e->reader[id])
-	      	{
-		  e->nr++;
-		  e->reader[id] = 1;
-		  ssht_log_set_insert(log, btmp->addr + i, e);
-		}
-#endif	/* BIT_OPTS */
-
-	      return NO_CONFLICT;
+	      *i = m;
+	      return btmp;
 	    }
+	  match &= match - 1;
 	}
 
-      btmp = btmp->next;
-    } 
-  while (btmp != NULL);
-
-  btmp = bu;
-
-  do 
-    {
-      for (i = 0; i < ADDR_PER_CL; i++) 
+      empty &= SSHT_TAG_VALID;
+      if (bfree == NULL && empty)
 	{
-	  if (btmp->addr[i] == 0) 
-	    {
-	      ssht_rw_entry_t* e = btmp->entry + i;
-	      btmp->addr[i] = addr;
-#if defined(BIT_OPTS)
-	      rw_entry_ssht_set(e, id);
-#else
-	      e->nr++;
-	      e->reader[id] = 1;
-#endif	/* BIT_OPTS */
-	      ssht_log_set_insert(log, btmp->addr + i, e);
-	      return NO_CONFLICT;
-	    }
+	  bfree = btmp;
+	  ifree = tag_probe_first(empty);
 	}
 
-      if (btmp->next == NULL) 
+      if (btmp->next == NULL)
 	{
-	  btmp->next = ssht_bucket_new();
+	  break;
 	}
-
       btmp = btmp->next;
-    } 
-  while (1);
+    }
+
+  if (bfree == NULL)
+    {
+      bfree = btmp->next = ssht_bucket_new();
+      ifree = 0;
+    }
+
+  *i = ifree;
+  return bfree;
+}
+
+TM2C_CONFLICT_T 
+bucket_insert_r(bucket_t* bu, ssht_log_set_t* log, uint32_t id, uintptr_t addr) 
+{
+  uint32_t i;
+  uint8_t tag = SSHT_TAG(addr);
+  bucket_t* btmp = bucket_probe(bu, addr, tag, &i);
+
+  /* a free entry cannot conflict */
+  TM2C_CONFLICT_T conflict = ssht_rw_entry_insert_r(btmp->entry + i, btmp->addr + i, addr, log, id);
+  if (conflict == NO_CONFLICT)
+    {
+      btmp->tag[i] = tag;
+    }
+  return conflict;
 }  
 
 TM2C_CONFLICT_T 
 bucket_insert_w(bucket_t* bu, ssht_log_set_t* log, uint32_t id, uintptr_t addr) 
 {
   uint32_t i;
-  bucket_t* btmp = bu;
-  do 
-    {
-      for (i = 0; i < ADDR_PER_CL; i++) 
-	{
-	  if (btmp->addr[i] == addr)                               /* there is an entry for this addr */
-	    {
-	      ssht_rw_entry_t* e = btmp->entry + i;
-	      if (e->writer != SSHT_NO_WRITER && e->writer != id) /* there is a writer for this entry */
-		{
-#if !defined(NOCM) && !defined(BACKOFF_RETRY)                    /* any other CM (greedy, wholly, faircm) */
-		  if (contention_manager_raw_waw(id, e->writer, WRITE_AFTER_WRITE)) 
-		    {
-		      btmp->addr[i] = addr;
-		      e->writer = id;
-		      ssht_log_set_insert(log, btmp->addr + i, e);
-		      return NO_CONFLICT;
-		    }
-		  else 
-		    {
-		      return WRITE_AFTER_WRITE;
-		    }
-#else   /* NOCM */
-		  return WRITE_AFTER_WRITE;
-#endif	/* NOCM */
-		}
-#if defined(BIT_OPTS)
-	      else if (rw_entry_ssht_has_readers(e) && !rw_entry_ssht_is_unique_reader(e, id))
-#else
-	      else if (e->nr > 1 || (e->nr == 1 && e->reader[id] == 0))
-#endif	/* BIT_OPTS */
-		{
-#if !defined(NOCM) && !defined(BACKOFF_RETRY) 			/* if any other CM (greedy, wholly, faircm) */
-#  if defined(BIT_OPTS)
-		  uint8_t readers[MAX_READERS];
-		  rw_entry_ssht_fetch_readers(e, readers);
-#  else
-		  uint8_t* readers = e->reader;
-#  endif
+  uint8_t tag = SSHT_TAG(addr);
+  bucket_t* btmp = bucket_probe(bu, addr, tag, &i);
 
-		  if (contention_manager_war(id, readers, WRITE_AFTER_READ))
-		    {
-		      btmp->addr[i] = addr;
-		      e->writer = id;
-		      ssht_log_set_insert(log, btmp->addr + i, e);
-		      return NO_CONFLICT;
-		    }
-		  else
-		    {
-		      return WRITE_AFTER_READ;
-		    }
-#else
-		  return WRITE_AFTER_READ;
-#endif	/* NOCM */
-		}
-	      else		/* 1 reader and this reader is node id */
-		{
-		  btmp->addr[i] = addr;
-		  e->writer = id;
-		  ssht_log_set_insert(log, btmp->addr + i, e);
-		  return NO_CONFLICT;
-		}
-	    }
-	}
-    
-      btmp = btmp->next;
+  /* a free entry cannot conflict */
+  TM2C_CONFLICT_T conflict = ssht_rw_entry_insert_w(btmp->entry + i, btmp->addr + i, addr, log, id);
+  if (conflict == NO_CONFLICT)
+    {
+      btmp->tag[i] = tag;
     }
-  while (btmp != NULL);
+  return conflict;
+}
 
-  btmp = bu;
-  do
+/* returns the rw entry of addr (NULL if addr is not in the bucket) */
+ssht_rw_entry_t*
+bucket_lookup(bucket_t* bu, uintptr_t addr)
+{
+  uint8_t tag = SSHT_TAG(addr);
+  bucket_t* btmp = bu;
+  do 
     {
-      for (i = 0; i < ADDR_PER_CL; i++)
+      uint32_t empty;
+      uint32_t match = tag_probe(btmp->tag, tag, &empty) & SSHT_TAG_VALID;
+      while (match)
 	{
-	  if (btmp->addr[i] == 0) 
+	  uint32_t m = tag_probe_first(match);
+	  if (btmp->addr[m] == addr) 
 	    {
-	      ssht_rw_entry_t* e = btmp->entry + i;
-	      e->writer = id;
-	      btmp->addr[i] = addr;
-	      ssht_log_set_insert(log, btmp->addr + i, e);
-	      return NO_CONFLICT;
+	      return btmp->entry + m;
 	    }
-	}
-
-      if (btmp->next == NULL)
-	{
-	  btmp->next = ssht_bucket_new();
+	  match &= match - 1;
 	}
 
       btmp = btmp->next;
     } 
-  while (1);
+  while (btmp != NULL);
+
+  return NULL;
 }
 
 void 
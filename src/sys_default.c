@@ -317,9 +317,18 @@ sys_tm2c_rpc_req_reply(nodeid_t sender, TM2C_RPC_REPLY_TYPE cmd, tm_addr_t addr,
   reply.type = cmd;
   reply.address = (uintptr_t) addr;
   reply.response = response;
+#if defined(TX_PROFILE)
+  /* the response of a TM2C_RPC_RELEASE is not a conflict */
+  if (response != NO_CONFLICT && cmd != TM2C_RPC_RELEASE_RESPONSE)
+    {
+      tm_intern_addr_t address = (tm_intern_addr_t) addr;
+      reply.nodeId = tm2c_ht_holder(tm2c_ht, sender, &address);
+      reply.address = address;
+    }
+#endif
 
   PRINTD("sys_tm2c_rpc_req_reply: src=%u target=%d", reply.nodeId, sender);
-#ifdef PGAS
+#if defined(PGAS) || defined(TM2C_RPC_HAS_RMW)
   reply.value = value;
 #endif
 
@@ -329,6 +338,7 @@ sys_tm2c_rpc_req_reply(nodeid_t sender, TM2C_RPC_REPLY_TYPE cmd, tm_addr_t addr,
 #else
   ssmp_send(sender, msg);
 #endif
+  TM2C_STATS_SENT(1);
 }
 
 
@@ -360,8 +370,15 @@ dsl_service()
 
   while (1) 
     {
-      ssmp_recv_color_start(cbuf, msg);
-      sender = msg->sender;
+#if defined(DSL_WAITQ)
+      if (!dsl_waitq_retry((TM2C_RPC_REQ*) msg, &sender))
+#endif
+	{
+	  ssmp_recv_color_start(cbuf, msg);
+	  sender = msg->sender;
+	  TM2C_STATS_RECV(1);
+	  TM2C_STATS_REQ(((TM2C_RPC_REQ*) msg)->type);
+	}
 
       tm2c_rpc_remote = (TM2C_RPC_REQ*) msg;
 
@@ -378,6 +395,8 @@ dsl_service()
 	  cm_metadata_core[sender].timestamp = getticks() - (ticks) tm2c_rpc_remote->tx_metadata;
 #  endif
 	}
+#elif defined(DYNAMIC_CM)
+      tm2c_cm->priority(sender, tm2c_rpc_remote->tx_metadata);
 #endif
     
 
@@ -386,6 +405,12 @@ dsl_service()
 	case TM2C_RPC_LOAD:
 	  {
 	    TM2C_CONFLICT_T conflict = try_load(sender, tm2c_rpc_remote->address);
+#if defined(DSL_WAITQ)
+	    if (conflict != NO_CONFLICT && dsl_waitq_defer(sender, tm2c_rpc_remote))
+	      {
+		break;		/* answered when it is retried */
+	      }
+#endif
 #ifdef PGAS
 	    uint64_t val;
 	    if (tm2c_rpc_remote->num_words == 1)
@@ -406,7 +431,7 @@ dsl_service()
 	    if (conflict != NO_CONFLICT)
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 #ifdef PGAS
@@ -419,6 +444,12 @@ dsl_service()
 	case TM2C_RPC_STORE:
 	  {
 	    TM2C_CONFLICT_T conflict = try_store(sender, tm2c_rpc_remote->address);
+#if defined(DSL_WAITQ)
+	    if (conflict != NO_CONFLICT && dsl_waitq_defer(sender, tm2c_rpc_remote))
+	      {
+		break;		/* answered when it is retried */
+	      }
+#endif
 	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
 				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
 
@@ -426,7 +457,7 @@ dsl_service()
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
 
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 #ifdef PGAS
@@ -441,6 +472,98 @@ dsl_service()
 #endif	/* PGAS */
 	    break;
 	  }
+#if defined(PGAS)
+	case TM2C_RPC_STORE_COMMIT:
+	  {
+	    /* the deferred last store of a transaction: locked as a
+	       TM2C_RPC_STORE, then persisted and released as a
+	       TM2C_RPC_RMV_NODE (on a conflict, only released). The reply
+	       comes after the write-back: the writes are durable when the
+	       app returns from the commit */
+	    TM2C_CONFLICT_T conflict = try_store(sender, tm2c_rpc_remote->address);
+	    if (conflict == NO_CONFLICT)
+	      {
+		write_set_pgas_insert(PGAS_write_sets[sender], tm2c_rpc_remote->write_value, tm2c_rpc_remote->address);
+		write_set_pgas_persist(PGAS_write_sets[sender]);
+	      }
+	    write_set_pgas_empty(PGAS_write_sets[sender]);
+	    tm2c_ht_delete_node(tm2c_ht, sender);
+
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+	    break;
+	  }
+#endif	/* PGAS */
+#if !defined(PGAS)
+	case TM2C_RPC_STORE_MULTI:
+	  {
+	    TM2C_CONFLICT_T conflict = try_store_multi(sender, tm2c_rpc_remote);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* !PGAS */
+#if defined(TM2C_RANGE_LOCKS)
+	case TM2C_RPC_LOAD_RANGE:
+	  {
+	    TM2C_CONFLICT_T conflict = try_load_range(sender, tm2c_rpc_remote->address, 
+						      tm2c_rpc_remote->num_words);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* TM2C_RANGE_LOCKS */
+#if defined(INVISIBLE_READS)
+	case TM2C_RPC_VALIDATE:
+	  {
+	    TM2C_CONFLICT_T conflict = try_validate(sender);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* INVISIBLE_READS */
+#if defined(PGAS_MVCC)
+	case TM2C_RPC_LOAD_SNAPSHOT:
+	  {
+	    int64_t val = 0;
+	    TM2C_CONFLICT_T conflict = try_load_snapshot(sender, tm2c_rpc_remote->address,
+							 tm2c_rpc_remote->num_words, &val);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, val, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* read-only: the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* PGAS_MVCC */
 #ifdef PGAS
 	case TM2C_RPC_STORE_INC:
 	  {
@@ -459,7 +582,7 @@ dsl_service()
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
 		write_set_pgas_empty(PGAS_write_sets[sender]);
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 	      }
@@ -491,6 +614,61 @@ dsl_service()
 	    break;
 	  }
 #endif
+#if defined(TM2C_RPC_HAS_RMW)
+#  if defined(PGAS)
+	case TM2C_RPC_RMW:
+	  {
+	    int64_t old = 0;
+	    TM2C_CONFLICT_T conflict = try_rmw(sender, tm2c_rpc_remote, &old);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, old, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+		write_set_pgas_empty(PGAS_write_sets[sender]);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#  endif	/* PGAS */
+	case TM2C_RPC_RMW_NONTX:
+	  {
+	    int64_t old = 0;
+	    TM2C_CONFLICT_T conflict = try_rmw_nontx(sender, tm2c_rpc_remote, &old);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_NONTX_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, old, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* TM2C_RPC_HAS_RMW */
+#if defined(IRREVOCABLE)
+	case TM2C_RPC_IRREVOC:
+	  {
+	    TM2C_CONFLICT_T conflict = tm2c_irrevoc_grant(sender);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+	case TM2C_RPC_IRREVOC_RLS:
+	  {
+	    /* after the releases of the commit of sender */
+	    tm2c_irrevoc_release(sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* IRREVOCABLE */
 	case TM2C_RPC_RMV_NODE:
 	  {
 #ifdef PGAS
@@ -502,7 +680,7 @@ dsl_service()
 #endif
 	    tm2c_ht_delete_node(tm2c_ht, sender);
 
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 	    cm_metadata_core[sender].timestamp = 0;
 #endif
 	    break;
@@ -513,6 +691,30 @@ dsl_service()
 	case TM2C_RPC_STORE_FINISH:
 	  tm2c_ht_delete(tm2c_ht, sender, tm2c_rpc_remote->address, WRITE);
 	  break;
+	case TM2C_RPC_RELEASE:
+	  {
+	    /* the response is whether the sender still holds any lock here */
+	    uint32_t holds = tm2c_ht_release(tm2c_ht, sender, tm2c_rpc_remote->address);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_RELEASE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, (TM2C_CONFLICT_T) holds);
+	    break;
+	  }
+	case TM2C_RPC_DOWNGRADE:
+	  tm2c_ht_downgrade(tm2c_ht, sender, tm2c_rpc_remote->address);
+#ifdef PGAS
+	  write_set_pgas_remove(PGAS_write_sets[sender], tm2c_rpc_remote->address);
+#endif	/* PGAS */
+	  break;
+#if defined(TX_PROFILE)
+	case TM2C_RPC_PROFILE:
+	  tm2c_profile_merge((tm2c_profile_msg_t*) tm2c_rpc_remote);
+	  break;
+#endif
+#if defined(TX_HISTO)
+	case TM2C_RPC_HISTO:
+	  tm2c_histo_merge((tm2c_histo_msg_t*) tm2c_rpc_remote);
+	  break;
+#endif
 	case TM2C_RPC_STATS:
 	  {
 	    TM2C_RPC_STATS_T* tm2c_rpc_rem_stats = (TM2C_RPC_STATS_T*) tm2c_rpc_remote;
@@ -534,6 +736,9 @@ dsl_service()
 
 	    if (++tm2c_stats_received >= 2*NUM_APP_NODES) 
 	      {
+#if defined(STATS_EXPORT)
+		tm2c_stats_dsl();
+#endif
 		uint32_t n;
 		for (n = 0; n < TOTAL_NODES(); n++)
 		  {
@@ -542,6 +747,8 @@ dsl_service()
 		      {
 #if defined(USE_HASHTABLE_SSHT)
 			ssht_stats_print(tm2c_ht, SSHT_DBG_UTILIZATION_DTL);
+#elif defined(USE_HASHTABLE_OAHT)
+			oaht_stats_print(tm2c_ht, SSHT_DBG_UTILIZATION_DTL);
 #endif
 		      }
 		    BARRIER_DSL;
@@ -342,6 +342,7 @@ sys_tm2c_rpc_req_reply(nodeid_t sender, TM2C_RPC_REPLY_TYPE cmd, tm_addr_t addr,
   /* PF_START(10); */
   ssmp_send(sender, msg);
   /* PF_STOP(10); */
+  TM2C_STATS_SENT(1);
 }
 
 
@@ -368,8 +369,15 @@ dsl_service()
 
   while(1) 
     {
-      ssmp_recv_color_start(cbuf, msg);
-      sender = msg->sender;
+#if defined(DSL_WAITQ)
+      if (!dsl_waitq_retry((TM2C_RPC_REQ*) msg, &sender))
+#endif
+	{
+	  ssmp_recv_color_start(cbuf, msg);
+	  sender = msg->sender;
+	  TM2C_STATS_RECV(1);
+	  TM2C_STATS_REQ(((TM2C_RPC_REQ*) msg)->type);
+	}
 
       tm2c_rpc_remote = (TM2C_RPC_REQ *) msg;
  
@@ -386,6 +394,8 @@ dsl_service()
 	  cm_metadata_core[sender].timestamp = getticks() - (ticks) tm2c_rpc_remote->tx_metadata;
 #  endif
 	}
+#elif defined(DYNAMIC_CM)
+      tm2c_cm->priority(sender, tm2c_rpc_remote->tx_metadata);
 #endif
     
 
@@ -394,6 +404,12 @@ dsl_service()
 	case TM2C_RPC_LOAD:
 	  {
 	    TM2C_CONFLICT_T conflict = try_load(sender, tm2c_rpc_remote->address);
+#if defined(DSL_WAITQ)
+	    if (conflict != NO_CONFLICT && dsl_waitq_defer(sender, tm2c_rpc_remote))
+	      {
+		break;		/* answered when it is retried */
+	      }
+#endif
 #ifdef PGAS
 	    uint64_t val;
 	    if (tm2c_rpc_remote->num_words == 1)
@@ -414,7 +430,7 @@ dsl_service()
 	    if (conflict != NO_CONFLICT)
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 #ifdef PGAS
@@ -427,6 +443,12 @@ dsl_service()
 	case TM2C_RPC_STORE:
 	  {
 	    TM2C_CONFLICT_T conflict = try_store(sender, tm2c_rpc_remote->address);
+#if defined(DSL_WAITQ)
+	    if (conflict != NO_CONFLICT && dsl_waitq_defer(sender, tm2c_rpc_remote))
+	      {
+		break;		/* answered when it is retried */
+	      }
+#endif
 	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
 				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
 
@@ -434,7 +456,7 @@ dsl_service()
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
 
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 #ifdef PGAS
@@ -449,6 +471,98 @@ dsl_service()
 #endif	/* PGAS */
 	    break;
 	  }
+#if defined(PGAS)
+	case TM2C_RPC_STORE_COMMIT:
+	  {
+	    /* the deferred last store of a transaction: locked as a
+	       TM2C_RPC_STORE, then persisted and released as a
+	       TM2C_RPC_RMV_NODE (on a conflict, only released). The reply
+	       comes after the write-back: the writes are durable when the
+	       app returns from the commit */
+	    TM2C_CONFLICT_T conflict = try_store(sender, tm2c_rpc_remote->address);
+	    if (conflict == NO_CONFLICT)
+	      {
+		write_set_pgas_insert(PGAS_write_sets[sender], tm2c_rpc_remote->write_value, tm2c_rpc_remote->address);
+		write_set_pgas_persist(PGAS_write_sets[sender]);
+	      }
+	    write_set_pgas_empty(PGAS_write_sets[sender]);
+	    tm2c_ht_delete_node(tm2c_ht, sender);
+
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+	    break;
+	  }
+#endif	/* PGAS */
+#if !defined(PGAS)
+	case TM2C_RPC_STORE_MULTI:
+	  {
+	    TM2C_CONFLICT_T conflict = try_store_multi(sender, tm2c_rpc_remote);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* !PGAS */
+#if defined(TM2C_RANGE_LOCKS)
+	case TM2C_RPC_LOAD_RANGE:
+	  {
+	    TM2C_CONFLICT_T conflict = try_load_range(sender, tm2c_rpc_remote->address, 
+						      tm2c_rpc_remote->num_words);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* TM2C_RANGE_LOCKS */
+#if defined(INVISIBLE_READS)
+	case TM2C_RPC_VALIDATE:
+	  {
+	    TM2C_CONFLICT_T conflict = try_validate(sender);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* INVISIBLE_READS */
+#if defined(PGAS_MVCC)
+	case TM2C_RPC_LOAD_SNAPSHOT:
+	  {
+	    int64_t val = 0;
+	    TM2C_CONFLICT_T conflict = try_load_snapshot(sender, tm2c_rpc_remote->address,
+							 tm2c_rpc_remote->num_words, &val);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, val, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* read-only: the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* PGAS_MVCC */
 #ifdef PGAS
 	case TM2C_RPC_STORE_INC:
 	  {
@@ -503,6 +617,28 @@ dsl_service()
 	    break;
 	  }
 #endif
+#if defined(IRREVOCABLE)
+	case TM2C_RPC_IRREVOC:
+	  {
+	    TM2C_CONFLICT_T conflict = tm2c_irrevoc_grant(sender);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+	case TM2C_RPC_IRREVOC_RLS:
+	  {
+	    /* after the releases of the commit of sender */
+	    tm2c_irrevoc_release(sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* IRREVOCABLE */
 	case TM2C_RPC_RMV_NODE:
 	  {
 #ifdef PGAS
@@ -514,7 +650,7 @@ dsl_service()
 #endif
 	    tm2c_ht_delete_node(tm2c_ht, sender);
 
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 	    cm_metadata_core[sender].timestamp = 0;
 #endif
 	    break;
@@ -525,6 +661,20 @@ dsl_service()
 	case TM2C_RPC_STORE_FINISH:
 	  tm2c_ht_delete(tm2c_ht, sender, tm2c_rpc_remote->address, WRITE);
 	  break;
+	case TM2C_RPC_RELEASE:
+	  {
+	    /* the response is whether the sender still holds any lock here */
+	    uint32_t holds = tm2c_ht_release(tm2c_ht, sender, tm2c_rpc_remote->address);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_RELEASE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, (TM2C_CONFLICT_T) holds);
+	    break;
+	  }
+	case TM2C_RPC_DOWNGRADE:
+	  tm2c_ht_downgrade(tm2c_ht, sender, tm2c_rpc_remote->address);
+#ifdef PGAS
+	  write_set_pgas_remove(PGAS_write_sets[sender], tm2c_rpc_remote->address);
+#endif	/* PGAS */
+	  break;
 	case TM2C_RPC_STATS:
 	  {
 	    TM2C_RPC_STATS_SEND_T* tm2c_rpc_rem_stats = (TM2C_RPC_STATS_SEND_T*) tm2c_rpc_remote;
@@ -558,6 +708,9 @@ dsl_service()
 
 	    if (++tm2c_stats_received >= 7*NUM_APP_NODES) 
 	      {
+#if defined(STATS_EXPORT)
+		tm2c_stats_dsl();
+#endif
 		tm2c_stats_total = tm2c_stats_commits + tm2c_stats_aborts;
 		uint32_t n;
 		for (n = 0; n < TOTAL_NODES(); n++)
@@ -565,7 +718,11 @@ dsl_service()
 		    BARRIER_DSL;
 		    if (n == NODE_ID())
 		      {
+#if defined(USE_HASHTABLE_SSHT)
 			ssht_stats_print(tm2c_ht, 0);
+#elif defined(USE_HASHTABLE_OAHT)
+			oaht_stats_print(tm2c_ht, 0);
+#endif
 		      }
 		    BARRIER_DSL;
 		  }
@@ -427,6 +427,7 @@ sys_tm2c_rpc_req_reply(nodeid_t sender,
   tmc_udn_send_buffer(udn_header[sender], UDN0_DEMUX_TAG, tm2c_rpc_reply, TM2C_RPC_REPLY_SIZE_WORDS);
 
   /* tmc_udn_send_buffer(udn_header[sender], demux_tag_mine, &reply, TM2C_RPC_REPLY_WORDS); */
+  TM2C_STATS_SENT(1);
 }
 
 
@@ -440,9 +441,15 @@ dsl_service()
   while (1) 
     {
       /* PF_START(5); */
-      tmc_udn0_receive_buffer(tm2c_rpc_remote, TM2C_RPC_REQ_SIZE_WORDS);
-
-      sender = tm2c_rpc_remote->nodeId;
+#if defined(DSL_WAITQ)
+      if (!dsl_waitq_retry(tm2c_rpc_remote, &sender))
+#endif
+	{
+	  tmc_udn0_receive_buffer(tm2c_rpc_remote, TM2C_RPC_REQ_SIZE_WORDS);
+	  sender = tm2c_rpc_remote->nodeId;
+	  TM2C_STATS_RECV(1);
+	  TM2C_STATS_REQ(tm2c_rpc_remote->type);
+	}
       
 #if defined(WHOLLY) || defined(FAIRCM)
       cm_metadata_core[sender].timestamp = (ticks) tm2c_rpc_remote->tx_metadata;
@@ -455,6 +462,8 @@ dsl_service()
 	  cm_metadata_core[sender].timestamp = getticks() - (ticks) tm2c_rpc_remote->tx_metadata;
 #  endif
 	}
+#elif defined(DYNAMIC_CM)
+      tm2c_cm->priority(sender, tm2c_rpc_remote->tx_metadata);
 #endif
       /* PRINT("CMD from %02d | type: %d | addr: %u", sender, tm2c_rpc_remote->type, tm2c_rpc_remote->address); */
 
@@ -464,6 +473,12 @@ dsl_service()
 	  {
 
 	    TM2C_CONFLICT_T conflict = try_load(sender, tm2c_rpc_remote->address);
+#if defined(DSL_WAITQ)
+	    if (conflict != NO_CONFLICT && dsl_waitq_defer(sender, tm2c_rpc_remote))
+	      {
+		break;		/* answered when it is retried */
+	      }
+#endif
 #ifdef PGAS
 	    uint64_t val;
 	    if (tm2c_rpc_remote->num_words == 1)
@@ -484,7 +499,7 @@ dsl_service()
 	    if (conflict != NO_CONFLICT)
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 #ifdef PGAS
@@ -497,6 +512,12 @@ dsl_service()
 	case TM2C_RPC_STORE:
 	  {
 	    TM2C_CONFLICT_T conflict = try_store(sender, tm2c_rpc_remote->address);
+#if defined(DSL_WAITQ)
+	    if (conflict != NO_CONFLICT && dsl_waitq_defer(sender, tm2c_rpc_remote))
+	      {
+		break;		/* answered when it is retried */
+	      }
+#endif
 	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
 				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
 
@@ -504,7 +525,7 @@ dsl_service()
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
 
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 #ifdef PGAS
@@ -519,6 +540,98 @@ dsl_service()
 #endif	/* PGAS */
 	    break;
 	  }
+#if defined(PGAS)
+	case TM2C_RPC_STORE_COMMIT:
+	  {
+	    /* the deferred last store of a transaction: locked as a
+	       TM2C_RPC_STORE, then persisted and released as a
+	       TM2C_RPC_RMV_NODE (on a conflict, only released). The reply
+	       comes after the write-back: the writes are durable when the
+	       app returns from the commit */
+	    TM2C_CONFLICT_T conflict = try_store(sender, tm2c_rpc_remote->address);
+	    if (conflict == NO_CONFLICT)
+	      {
+		write_set_pgas_insert(PGAS_write_sets[sender], tm2c_rpc_remote->write_value, tm2c_rpc_remote->address);
+		write_set_pgas_persist(PGAS_write_sets[sender]);
+	      }
+	    write_set_pgas_empty(PGAS_write_sets[sender]);
+	    tm2c_ht_delete_node(tm2c_ht, sender);
+
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+	    break;
+	  }
+#endif	/* PGAS */
+#if !defined(PGAS)
+	case TM2C_RPC_STORE_MULTI:
+	  {
+	    TM2C_CONFLICT_T conflict = try_store_multi(sender, tm2c_rpc_remote);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* !PGAS */
+#if defined(TM2C_RANGE_LOCKS)
+	case TM2C_RPC_LOAD_RANGE:
+	  {
+	    TM2C_CONFLICT_T conflict = try_load_range(sender, tm2c_rpc_remote->address, 
+						      tm2c_rpc_remote->num_words);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* TM2C_RANGE_LOCKS */
+#if defined(INVISIBLE_READS)
+	case TM2C_RPC_VALIDATE:
+	  {
+	    TM2C_CONFLICT_T conflict = try_validate(sender);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE, 
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+
+	    if (conflict != NO_CONFLICT)
+	      {
+		tm2c_ht_delete_node(tm2c_ht, sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+		cm_metadata_core[sender].timestamp = 0;
+#endif
+	      }
+	    break;
+	  }
+#endif	/* INVISIBLE_READS */
+#if defined(PGAS_MVCC)
+	case TM2C_RPC_LOAD_SNAPSHOT:
+	  {
+	    int64_t val = 0;
+	    TM2C_CONFLICT_T conflict = try_load_snapshot(sender, tm2c_rpc_remote->address,
+							 tm2c_rpc_remote->num_words, &val);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_LOAD_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, val, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* read-only: the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* PGAS_MVCC */
 #ifdef PGAS
 	case TM2C_RPC_STORE_INC:
 	  {
@@ -537,7 +650,7 @@ dsl_service()
 	      {
 		tm2c_ht_delete_node(tm2c_ht, sender);
 		write_set_pgas_empty(PGAS_write_sets[sender]);
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 		cm_metadata_core[sender].timestamp = 0;
 #endif
 	      }
@@ -569,6 +682,28 @@ dsl_service()
 	    break;
 	  }
 #endif
+#if defined(IRREVOCABLE)
+	case TM2C_RPC_IRREVOC:
+	  {
+	    TM2C_CONFLICT_T conflict = tm2c_irrevoc_grant(sender);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_STORE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, conflict);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    /* the sender does not hold anything on this node */
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+	case TM2C_RPC_IRREVOC_RLS:
+	  {
+	    /* after the releases of the commit of sender */
+	    tm2c_irrevoc_release(sender);
+#if defined(GREEDY) || defined(DYNAMIC_CM)
+	    cm_metadata_core[sender].timestamp = 0;
+#endif
+	    break;
+	  }
+#endif	/* IRREVOCABLE */
 	case TM2C_RPC_RMV_NODE:
 	  {
 #ifdef PGAS
@@ -580,7 +715,7 @@ dsl_service()
 #endif
 	    tm2c_ht_delete_node(tm2c_ht, sender);
 
-#if defined(GREEDY)
+#if defined(GREEDY) || defined(DYNAMIC_CM)
 	    cm_metadata_core[sender].timestamp = 0;
 #endif
 	    break;
@@ -591,6 +726,20 @@ dsl_service()
 	case TM2C_RPC_STORE_FINISH:
 	  tm2c_ht_delete(tm2c_ht, sender, tm2c_rpc_remote->address, WRITE);
 	  break;
+	case TM2C_RPC_RELEASE:
+	  {
+	    /* the response is whether the sender still holds any lock here */
+	    uint32_t holds = tm2c_ht_release(tm2c_ht, sender, tm2c_rpc_remote->address);
+	    sys_tm2c_rpc_req_reply(sender, TM2C_RPC_RELEASE_RESPONSE,
+				 (tm_addr_t) tm2c_rpc_remote->address, 0, (TM2C_CONFLICT_T) holds);
+	    break;
+	  }
+	case TM2C_RPC_DOWNGRADE:
+	  tm2c_ht_downgrade(tm2c_ht, sender, tm2c_rpc_remote->address);
+#ifdef PGAS
+	  write_set_pgas_remove(PGAS_write_sets[sender], tm2c_rpc_remote->address);
+#endif	/* PGAS */
+	  break;
 	case TM2C_RPC_STATS:
 	  {
 	    uint32_t w;
@@ -633,6 +782,9 @@ dsl_service()
 
 	    if (++tm2c_stats_received >= 2*NUM_APP_NODES) 
 	      {
+#if defined(STATS_EXPORT)
+		tm2c_stats_dsl();
+#endif
 		uint32_t n;
 		for (n = 0; n < TOTAL_NODES(); n++)
 		  {
@@ -641,6 +793,8 @@ dsl_service()
 		      {
 #if defined(USE_HASHTABLE_SSHT)
 			ssht_stats_print(tm2c_ht, SSHT_DBG_UTILIZATION_DTL);
+#elif defined(USE_HASHTABLE_OAHT)
+			oaht_stats_print(tm2c_ht, SSHT_DBG_UTILIZATION_DTL);
 #endif
 		      }
 		    BARRIER_DSL;
@@ -104,6 +104,9 @@ tm2c_init()
   PF_MSG(10, "sending");
 
   sys_tm2c_init();
+#if defined(STATS_EXPORT)
+  tm2c_stats_init();
+#endif
   if (!is_app_core(ID)) 
     {
       //dsl node
@@ -122,12 +125,36 @@ tm2c_init()
     }
 }
 
+#if defined(DYNAMIC_CM)
+/* selects the contention manager of -cm=<name> and removes it from the
+   arguments */
+static void
+tm2c_cm_args(int* argc, char** argv[])
+{
+  int p, cur = 1;
+  for (p = 1; p < *argc; p++)
+    {
+      if (strncmp("-cm=", (*argv)[p], strlen("-cm=")) == 0)
+	{
+	  tm2c_cm_select((*argv)[p] + strlen("-cm="));
+	  continue;
+	}
+      (*argv)[cur++] = (*argv)[p];
+    }
+  *argc = cur;
+}
+#endif	/* DYNAMIC_CM */
+
 void
 tm2c_init_system(int* argc, char** argv[])
 {
   /* calculate the getticks correction if DO_TIMINGS is set */
   PF_CORRECTION;
 
+#if defined(DYNAMIC_CM)
+  tm2c_cm_args(argc, argv);
+#endif
+
   /* call platform level initializer */
   sys_tm2c_init_system(argc, argv);
 
@@ -146,6 +173,45 @@ tm2c_init_system(int* argc, char** argv[])
   NUM_DSL_NODES = tot;
   NUM_APP_NODES = NUM_UES - tot;
 
+#if defined(DSL_NODE_WORKERS)
+  static const uint8_t node_workers[] = { DSL_NODE_WORKERS };
+  uint32_t workers = 0;
+  for (i = 0; i < DSL_NUM_PARTITIONS; i++)
+    {
+      workers += node_workers[i];
+    }
+  if (workers != NUM_DSL_NODES)
+    {
+      PRINT("%d DSL cores cannot run the %u workers of DSL_NODE_WORKERS", NUM_DSL_NODES, workers);
+      EXIT(1);
+    }
+#endif
+
+#if (ADDR_TO_DSL_SEL == 2)
+  /* the directory is initialized by node 0 before the barrier */
+#  if defined(DSL_NODE_WORKERS)
+  dsl_dir_init(DSL_NUM_PARTITIONS);
+#  else
+  dsl_dir_init(NUM_DSL_NODES);
+#  endif
+#endif
+
+#if defined(IRREVOCABLE)
+  /* the token is reset by the first dsl core before the barrier */
+  if (is_dsl_core(ID))
+    {
+      tm2c_irrevoc_init();
+    }
+#endif
+
+#if defined(STATS_EXPORT)
+  /* the file is truncated by the first dsl core before the barrier */
+  if (ID == min_dsl_id())
+    {
+      tm2c_stats_create();
+    }
+#endif
+
   tm2c_init_barrier();
 }
 /*
@@ -189,6 +255,19 @@ tm2c_term()
 
   tm2c_ht_free(tm2c_ht);
 
+#if (ADDR_TO_DSL_SEL == 2)
+  dsl_dir_term();
+#endif
+
+#if defined(DYNAMIC_CM)
+  tm2c_cm_term();
+#endif
+#if defined(DSL_WAITQ)
+  dsl_waitq_term();
+#endif
+#if defined(IRREVOCABLE)
+  tm2c_irrevoc_term();
+#endif
 #if !defined(NOCM) && !defined(BACKOFF_RETRY) /* if any other CM (greedy, wholly, faircm) */
   free(cm_metadata_core);
 #endif
@@ -217,6 +296,10 @@ tm2c_term()
       free(tm2c_tx_node);
       free(tm2c_tx);
 
+#if (ADDR_TO_DSL_SEL == 2)
+      dsl_dir_term();
+#endif
+
     }
 }
 
@@ -234,30 +317,43 @@ tm2c_term()
     }
 
 
+/* per conflict type, and per site with TX_PROFILE */
+static inline void
+tm2c_tx_count_abort(tm2c_tx_t* tm2c_tx, TM2C_CONFLICT_T reason)
+{
+  switch (reason)
+    {
+    case READ_AFTER_WRITE:
+      tm2c_tx_node->aborts_raw++;
+      break;
+    case WRITE_AFTER_READ:
+      tm2c_tx_node->aborts_war++;
+      break;
+    case WRITE_AFTER_WRITE:
+      tm2c_tx_node->aborts_waw++;
+      break;
+    default:
+      /* nothing */
+      break;
+    }
+#if defined(TX_PROFILE)
+  tm2c_profile_abort(tm2c_tx->site_file, tm2c_tx->site_line, reason);
+#endif
+}
+
 void 
 tm2c_handle_abort(tm2c_tx_t* tm2c_tx, TM2C_CONFLICT_T reason) 
 {
   tm2c_rpc_rls_all(reason);
+#if defined(PGAS_MVCC)
+  pgas_mvcc_commit_end();
+#endif
   tm2c_tx->aborts++;
   
   /* PRINT_ON_ABORT(); */
   /* PRINT_ON_RETRY(); */
 
-  /* switch (reason) */
-  /*   { */
-  /*   case READ_AFTER_WRITE: */
-  /*     tm2c_tx->aborts_raw++; */
-  /*     break; */
-  /*   case WRITE_AFTER_READ: */
-  /*     tm2c_tx->aborts_war++; */
-  /*     break; */
-  /*   case WRITE_AFTER_WRITE: */
-  /*     tm2c_tx->aborts_waw++; */
-  /*     break; */
-  /*   default: */
-  /*     /\* nothing *\/ */
-  /*     break; */
-  /*   } */
+  tm2c_tx_count_abort(tm2c_tx, reason);
 
 #if !defined(PGAS)
   write_set_empty(tm2c_tx->write_set);
@@ -282,11 +378,125 @@ tm2c_handle_abort(tm2c_tx_t* tm2c_tx, TM2C_CONFLICT_T reason)
       ndelay(wait);
     }
 
+#elif defined(DYNAMIC_CM)
+  tm2c_cm->on_abort();
 #else
   wait_cycles(50 * (tm2c_tx->retries & 0xFF));
 #endif
 }
 
+#if defined(TX_NESTING) && !defined(PGAS)
+/* the savepoint of the innermost nested block that has one */
+static inline tm2c_tx_savepoint_t*
+tm2c_tx_savepoint_cur()
+{
+  uint32_t depth = tm2c_tx->nesting;
+  if (depth > TX_NESTING_MAX + 1)
+    {
+      depth = TX_NESTING_MAX + 1;
+    }
+  return tm2c_tx->savepoints + depth - 2;
+}
+
+tm2c_tx_savepoint_t*
+tm2c_tx_savepoint()
+{
+  tm2c_tx_savepoint_t* sp = tm2c_tx_savepoint_cur();
+  sp->retries = 0;
+  sp->ws_entries = tm2c_tx->write_set->nb_entries;
+  sp->ws_blocks_used = tm2c_tx->write_set->blocks_used;
+  sp->mem_info = *tm2c_tx->mem_info;
+  tm2c_rpc_savepoint(sp->contacted);
+  return sp;
+}
+
+void
+tm2c_tx_rollback(TM2C_CONFLICT_T reason)
+{
+  if (tm2c_tx->nesting < 2)
+    {
+      return;
+    }
+
+  tm2c_tx_savepoint_t* sp = tm2c_tx_savepoint_cur();
+  if (sp->retries >= TX_NESTING_RETRIES)
+    {
+      return;
+    }
+#if !defined(NOCM) && !defined(BACKOFF_RETRY)
+  /* aborted by a contention manager: the locks of the tx were dropped */
+  if (check_aborted())
+    {
+      return;
+    }
+#endif
+  if (!tm2c_rpc_rollback(sp->contacted))
+    {
+      return;
+    }
+
+  write_set_truncate(tm2c_tx->write_set, sp->ws_entries, sp->ws_blocks_used);
+  mem_info_on_rollback(tm2c_tx->mem_info, &sp->mem_info);
+  tm2c_tx->aborts++;
+  tm2c_tx_count_abort(tm2c_tx, reason);
+  tm2c_tx->nesting = (sp - tm2c_tx->savepoints) + 2;
+
+  wait_cycles(50 * (++sp->retries));
+  siglongjmp(sp->env, reason);
+}
+#endif	/* TX_NESTING */
+
+#if !defined(PGAS)
+void
+tm2c_tx_downgrade(tm_addr_t addr)
+{
+  tm_intern_addr_t intern_addr = to_intern_addr(addr);
+  tm2c_write_set_t* ws = tm2c_tx->write_set;
+#  if defined(TX_NESTING)
+  uint32_t first;
+  for (first = 0; first < ws->nb_entries; first++)
+    {
+      write_entry_t* we = ws->write_entries + first;
+      if (we->type != TYPE_BLOCK && we->address == intern_addr)
+	{
+	  break;
+	}
+    }
+
+  if (write_set_remove(ws, intern_addr) > 0 && tm2c_tx->nesting >= 2)
+    {
+      /* a rollback cannot bring back the dropped writes of the enclosing
+	 blocks: the nested blocks that kept them abort the whole tx */
+      tm2c_tx_savepoint_t* sp, * cur = tm2c_tx_savepoint_cur();
+      for (sp = tm2c_tx->savepoints; sp <= cur; sp++)
+	{
+	  if (sp->ws_entries > first)
+	    {
+	      sp->retries = TX_NESTING_RETRIES;
+	    }
+	}
+    }
+#  else
+  write_set_remove(ws, intern_addr);
+#  endif	/* TX_NESTING */
+
+  tm2c_rpc_downgrade(addr);
+}
+#endif	/* !PGAS */
+
+#if !defined(TM2C_RPC_HAS_RMW)
+/* NONTX_RMW where the messages have no room for the operation */
+int64_t
+tm2c_nontx_rmw_tx(tm_addr_t addr, uint32_t rmw, int64_t arg, int64_t arg2)
+{
+  int64_t old;
+  TX_START;
+  old = tx_rmw(WSET, addr, rmw, arg, arg2);
+  TX_COMMIT_NO_PUB_NO_STATS;
+  return old;
+}
+#endif	/* !TM2C_RPC_HAS_RMW */
+
 void
 tm2c_rpc_store_finish_all(unsigned int locked) 
 {
@@ -303,23 +513,30 @@ tm2c_rpc_store_finish_all(unsigned int locked)
     }
 }
 
+#if defined(INVISIBLE_READS)
+void
+tm2c_rpc_validate_all() 
+{
+  TM2C_CONFLICT_T conflict;
+  TXCHKABORTED();
+  if ((conflict = tm2c_rpc_validate()) != NO_CONFLICT)
+    {
+      TX_ABORT(conflict);
+    }
+}
+#endif	/* INVISIBLE_READS */
+
 void
 tm2c_rpc_store_all() 
 {
 #if !defined(PGAS)
-  write_entry_t* write_entries = tm2c_tx->write_set->write_entries;
-  uint32_t nb_entries = nb_entries = tm2c_tx->write_set->nb_entries;
-  uint32_t locked = 0;
-  while (locked < nb_entries) 
+  TM2C_CONFLICT_T conflict;
+  TXCHKABORTED();
+  conflict = tm2c_rpc_store_multi(tm2c_tx->write_set->write_entries, 
+				  tm2c_tx->write_set->nb_entries);
+  if (conflict != NO_CONFLICT)
     {
-      TM2C_CONFLICT_T conflict;
-      tm_addr_t addr = to_addr(write_entries[locked].address);
-      TXCHKABORTED();
-      if ((conflict = tm2c_rpc_store(addr, 0)) != NO_CONFLICT)
-	{
-	  TX_ABORT(conflict);
-	}
-      locked++;
+      TX_ABORT(conflict);
     }
 #else
   PRINT(" *** warning : using tm2c_rpc_store_all with PGAS");
@@ -51,10 +51,63 @@ TM2C_RPC_REQ *psc;
 int64_t read_value;
 unsigned long int* tm2c_rand_seeds;
 
+#if !defined(PGAS)
+/* scratch space of tm2c_rpc_store_multi: the addresses to be locked grouped 
+   per responsible node, [multi_next[n], multi_end[n]) for the node with seq n */
+static tm_intern_addr_t* multi_addrs = NULL;
+static uint32_t multi_addrs_size = 0;
+static uint32_t* multi_next;
+static uint32_t* multi_end;
+static nodeid_t* multi_round;
+#endif
+#if defined(TM2C_RANGE_LOCKS)
+static uint8_t* range_nodes;
+#endif
+
+/* split-phase loads: at most one TM2C_RPC_LOAD in flight per DSL node (for 
+   address async_addr[n]). Replies that are collected before the matching
+   tm2c_rpc_load_wait (e.g., because another load to the same node was issued) 
+   are kept in async_done until the end of the transaction. */
+typedef struct async_done_entry
+{
+  tm_intern_addr_t address;
+  int64_t value;
+} async_done_entry_t;
+
+static uint8_t* async_pending;
+static tm_intern_addr_t* async_addr;
+static uint32_t async_num_pending = 0;
+static async_done_entry_t* async_done = NULL;
+static uint32_t async_done_nb = 0;
+static uint32_t async_done_size = 0;
+static uint32_t async_done_cur = 0;
+
+#if defined(PGAS_FUSED_COMMIT)
+#  if defined(NOCM) || defined(BACKOFF_RETRY)
+/* no node is aborted remotely, hence a write lock can be acquired at any
+   point until the commit: the last TM2C_RPC_STORE is deferred until another
+   request is sent to its node, or, at commit time, it is sent as a
+   TM2C_RPC_STORE_COMMIT that also persists and releases the node */
+#    define PGAS_FUSED_STORE
+static uint8_t store_pending = 0;
+static nodeid_t store_pending_node;
+static tm_intern_addr_t store_pending_addr;
+static int64_t store_pending_value;
+#  endif
+#endif	/* PGAS_FUSED_COMMIT */
+
+#if defined(DSL_NODE_WORKERS)
+/* the workers (consecutive dsl cores) of every DSL node, and the first one */
+static const uint8_t dsl_node_workers[] = { DSL_NODE_WORKERS };
+static nodeid_t dsl_node_first[DSL_NUM_PARTITIONS];
+#endif
+
 static inline void tm2c_rpc_sendb(nodeid_t targ, TM2C_RPC_REQ_TYPE op, tm_intern_addr_t ad);
 static inline void tm2c_rpc_sendbr(nodeid_t targ, TM2C_RPC_REQ_TYPE op, tm_intern_addr_t ad, TM2C_CONFLICT_T resp);
 static inline void tm2c_rpc_sendbv(nodeid_t targ, TM2C_RPC_REQ_TYPE op, tm_intern_addr_t ad, int64_t va);
+static inline void tm2c_rpc_sendbm(nodeid_t targ, tm_intern_addr_t* ads, uint32_t num);
 static inline TM2C_CONFLICT_T tm2c_rpc_recvb(nodeid_t from);
+static inline TM2C_CONFLICT_T tm2c_rpc_async_drain(nodeid_t node_seq);
 /*
  * Takes the local representation of the address, and finds the node
  * responsible for it.
@@ -101,6 +154,43 @@ tm2c_app_init(void)
 	}
     }
 
+#if !defined(PGAS)
+  multi_next = (uint32_t*) malloc(NUM_DSL_NODES * sizeof(uint32_t));
+  multi_end = (uint32_t*) malloc(NUM_DSL_NODES * sizeof(uint32_t));
+  multi_round = (nodeid_t*) malloc(NUM_DSL_NODES * sizeof(nodeid_t));
+  if (multi_next == NULL || multi_end == NULL || multi_round == NULL)
+    {
+      PRINT("malloc multi_next / multi_end / multi_round");
+      EXIT(-1);
+    }
+#endif
+
+#if defined(TM2C_RANGE_LOCKS)
+  range_nodes = (uint8_t*) calloc(NUM_DSL_NODES, sizeof(uint8_t));
+  if (range_nodes == NULL)
+    {
+      PRINT("malloc range_nodes");
+      EXIT(-1);
+    }
+#endif
+
+  async_pending = (uint8_t*) calloc(NUM_DSL_NODES, sizeof(uint8_t));
+  async_addr = (tm_intern_addr_t*) malloc(NUM_DSL_NODES * sizeof(tm_intern_addr_t));
+  if (async_pending == NULL || async_addr == NULL)
+    {
+      PRINT("malloc async_pending / async_addr");
+      EXIT(-1);
+    }
+
+#if defined(DSL_NODE_WORKERS)
+  nodeid_t p, first = 0;
+  for (p = 0; p < DSL_NUM_PARTITIONS; p++)
+    {
+      dsl_node_first[p] = first;
+      first += dsl_node_workers[p];
+    }
+#endif
+
   tm2c_rand_seeds = seed_rand();
   sys_app_init();
   /* PRINT("[APP NODE] Initialized TM2C.."); */
@@ -126,6 +216,8 @@ tm2c_rpc_sendb(nodeid_t target, TM2C_RPC_REQ_TYPE command,
 #  else
   psc->tx_metadata = getticks() - tm2c_tx->start_ts;
 #  endif
+#elif defined(DYNAMIC_CM)
+  psc->tx_metadata = tm2c_cm->tx_metadata();
 #endif
 
   sys_sendcmd(psc, sizeof(TM2C_RPC_REQ), target);
@@ -151,6 +243,8 @@ tm2c_rpc_sendbr(nodeid_t target, TM2C_RPC_REQ_TYPE command,
 #  else
   psc->tx_metadata = getticks() - tm2c_tx->start_ts;
 #  endif
+#elif defined(DYNAMIC_CM)
+  psc->tx_metadata = tm2c_cm->tx_metadata();
 #endif
 
 #if defined(PGAS)
@@ -189,26 +283,149 @@ tm2c_rpc_sendbv(nodeid_t target, TM2C_RPC_REQ_TYPE command,
 #  else
   psc->tx_metadata = getticks() - tm2c_tx->start_ts;
 #  endif
+#elif defined(DYNAMIC_CM)
+  psc->tx_metadata = tm2c_cm->tx_metadata();
 #endif
 
-#if defined(PGAS)
-  psc->write_value = value;
+#if defined(PGAS) || defined(TM2C_RANGE_LOCKS)
+  psc->write_value = value;	/* the length for TM2C_RPC_LOAD_RANGE */
 #endif	/* PGAS */
   sys_sendcmd(psc, sizeof(TM2C_RPC_REQ), target);
 }
 
+/* sends a TM2C_RPC_STORE_MULTI with the first num (<= TM2C_RPC_MULTI_NUM)
+   addresses of ads */
+static inline void
+tm2c_rpc_sendbm(nodeid_t target, tm_intern_addr_t* addresses, uint32_t num)
+{
+  psc->type = TM2C_RPC_STORE_MULTI;
+#if defined(PLATFORM_TILERA)
+  psc->nodeId = TM2C_ID;
+#endif
+  psc->address = addresses[0];
+#if TM2C_RPC_MULTI_NUM > 1
+  psc->num_words = num;
+  uint32_t i;
+  for (i = 1; i < num; i++)
+    {
+      psc->multi_address[i - 1] = addresses[i];
+    }
+#endif
+
+#if defined(WHOLLY)
+  psc->tx_metadata = tm2c_tx_node->tx_committed;
+#elif defined(FAIRCM)
+  psc->tx_metadata = tm2c_tx_node->tx_duration;
+#elif defined(GREEDY)
+#  ifdef GREEDY_GLOBAL_TS
+  psc->tx_metadata = tm2c_tx->start_ts;
+#  else
+  psc->tx_metadata = getticks() - tm2c_tx->start_ts;
+#  endif
+#elif defined(DYNAMIC_CM)
+  psc->tx_metadata = tm2c_cm->tx_metadata();
+#endif
+
+  sys_sendcmd(psc, sizeof(TM2C_RPC_REQ), target);
+}
+
 static inline TM2C_CONFLICT_T
 tm2c_rpc_recvb(nodeid_t from)
 {
   TM2C_RPC_REPLY cmd;
   sys_recvcmd(&cmd, sizeof (TM2C_RPC_REPLY), from);
 
-#ifdef PGAS
+#if defined(PGAS) || defined(TM2C_RPC_HAS_RMW)
   read_value = cmd.value;
+#endif
+#if defined(TX_PROFILE)
+  if (cmd.response != NO_CONFLICT)
+    {
+#  if defined(PGAS)
+      cmd.address |= (tm_intern_addr_t) dsl_id_seq(from) << PGAS_DSL_MASK_BITS;
+#  endif
+      tm2c_profile_note(cmd.address, cmd.nodeId);
+    }
 #endif
   return cmd.response;
 }
 
+/* receives the reply of the outstanding async load to node_seq. If keep, a
+   successful reply is stored in async_done for a later tm2c_rpc_load_wait */
+static inline TM2C_CONFLICT_T
+tm2c_rpc_async_collect(nodeid_t node_seq, int keep)
+{
+  TM2C_CONFLICT_T response = tm2c_rpc_recvb(dsl_nodes[node_seq]);
+  async_pending[node_seq] = 0;
+  async_num_pending--;
+
+  if (response != NO_CONFLICT)
+    {
+      nodes_contacted[node_seq] = 0;
+    }
+  else if (keep)
+    {
+      if (async_done_nb == async_done_size)
+	{
+	  async_done_size = (async_done_size == 0) ? 16 : 2 * async_done_size;
+	  async_done = (async_done_entry_t*) realloc(async_done, async_done_size * sizeof(async_done_entry_t));
+	  if (async_done == NULL)
+	    {
+	      PRINT("realloc async_done");
+	      EXIT(-1);
+	    }
+	}
+      async_done[async_done_nb].address = async_addr[node_seq];
+#ifdef PGAS
+      async_done[async_done_nb].value = read_value;
+#endif
+      async_done_nb++;
+    }
+
+  return response;
+}
+
+#if defined(PGAS_FUSED_STORE)
+/* sends the deferred store as command (TM2C_RPC_STORE or _STORE_COMMIT) */
+static inline TM2C_CONFLICT_T
+tm2c_rpc_store_pending_send(TM2C_RPC_REQ_TYPE command)
+{
+  nodeid_t responsible_node_seq = store_pending_node;
+  nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
+  store_pending = 0;
+
+  nodes_contacted[responsible_node_seq]++;
+  tm2c_rpc_sendbv(responsible_node, command, store_pending_addr, store_pending_value);
+
+  TM2C_CONFLICT_T response = tm2c_rpc_recvb(responsible_node);
+  if (response != NO_CONFLICT)
+    {
+      nodes_contacted[responsible_node_seq] = 0;
+    }
+  return response;
+}
+#endif	/* PGAS_FUSED_STORE */
+
+/* must be called before any other request/reply with node_seq, so that the
+   reply of an outstanding async load is not mistaken for the new one */
+static inline TM2C_CONFLICT_T
+tm2c_rpc_async_drain(nodeid_t node_seq)
+{
+  TM2C_CONFLICT_T response = NO_CONFLICT;
+  if (async_num_pending > 0 && async_pending[node_seq])
+    {
+      response = tm2c_rpc_async_collect(node_seq, 1);
+    }
+#if defined(PGAS_FUSED_STORE)
+  /* the deferred store precedes any other request to its node */
+  if (store_pending && store_pending_node == node_seq && response == NO_CONFLICT)
+    {
+      response = tm2c_rpc_store_pending_send(TM2C_RPC_STORE);
+    }
+#endif	/* PGAS_FUSED_STORE */
+  return response;
+}
+
 /*
  * ____________________________________________________________________________________________
  TM interface _________________________________________________________________________________|
@@ -221,10 +438,31 @@ tm2c_rpc_load(tm_addr_t address, int words)
   tm_intern_addr_t intern_addr = to_intern_addr(address);
 
   nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
-  nodes_contacted[responsible_node_seq]++;
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      return response;
+    }
 
   nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
 
+#if defined(PGAS_MVCC)
+  /* a snapshot read does not register at the DSL: nothing to release */
+  if (tm2c_tx->snapshot)
+    {
+      intern_addr &= PGAS_DSL_ADDR_MASK;
+      TM2C_HISTO_RPC_START();
+      tm2c_rpc_sendbv(responsible_node, TM2C_RPC_LOAD_SNAPSHOT, intern_addr,
+		      PGAS_MVCC_PACK(tm2c_tx->snapshot, words));
+      response = tm2c_rpc_recvb(responsible_node);
+      TM2C_HISTO_RPC_END(TM2C_HISTO_LOAD);
+      return response;
+    }
+#endif	/* PGAS_MVCC */
+
+  nodes_contacted[responsible_node_seq]++;
+
+  TM2C_HISTO_RPC_START();
 #ifdef PGAS
   intern_addr &= PGAS_DSL_ADDR_MASK;
   tm2c_rpc_sendbv(responsible_node, TM2C_RPC_LOAD, intern_addr, words);
@@ -232,7 +470,8 @@ tm2c_rpc_load(tm_addr_t address, int words)
   tm2c_rpc_sendb(responsible_node, TM2C_RPC_LOAD, intern_addr);
 #endif
 
-  TM2C_CONFLICT_T response = tm2c_rpc_recvb(responsible_node);
+  response = tm2c_rpc_recvb(responsible_node);
+  TM2C_HISTO_RPC_END(TM2C_HISTO_LOAD);
   if (response != NO_CONFLICT)
     {
       nodes_contacted[responsible_node_seq] = 0;
@@ -248,10 +487,30 @@ tm2c_rpc_store(tm_addr_t address, int64_t value)
 {
   tm_intern_addr_t intern_addr = to_intern_addr(address);
   nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      return response;
+    }
+
+#if defined(PGAS_FUSED_STORE)
+  /* only the last store is deferred: send the previous one */
+  if (store_pending && (response = tm2c_rpc_async_drain(store_pending_node)) != NO_CONFLICT)
+    {
+      return response;
+    }
+
+  store_pending = 1;
+  store_pending_node = responsible_node_seq;
+  store_pending_addr = intern_addr & PGAS_DSL_ADDR_MASK;
+  store_pending_value = value;
+  return NO_CONFLICT;
+#endif	/* PGAS_FUSED_STORE */
 
   nodes_contacted[responsible_node_seq]++;
   nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
 
+  TM2C_HISTO_RPC_START();
 #ifdef PGAS
   intern_addr &= PGAS_DSL_ADDR_MASK;
   tm2c_rpc_sendbv(responsible_node, TM2C_RPC_STORE, intern_addr, value);
@@ -259,7 +518,8 @@ tm2c_rpc_store(tm_addr_t address, int64_t value)
   tm2c_rpc_sendb(responsible_node, TM2C_RPC_STORE, intern_addr); //make sync
 #endif
 
-  TM2C_CONFLICT_T response = tm2c_rpc_recvb(responsible_node);
+  response = tm2c_rpc_recvb(responsible_node);
+  TM2C_HISTO_RPC_END(TM2C_HISTO_STORE);
   if (response != NO_CONFLICT)
     {
       nodes_contacted[responsible_node_seq] = 0;
@@ -268,6 +528,118 @@ tm2c_rpc_store(tm_addr_t address, int64_t value)
   return response;
 }
 
+#if !defined(PGAS)
+/* 
+ * Locks the addresses in rounds: in each round, every DSL node that still
+ * has addresses to lock gets one TM2C_RPC_STORE_MULTI with up to
+ * TM2C_RPC_MULTI_NUM addresses, and only then do we collect the replies.
+ * Hence, the requests to different nodes overlap and each node costs one
+ * round-trip per TM2C_RPC_MULTI_NUM addresses. After a conflict no new round
+ * is started, but the replies of the current round are still collected.
+ */
+TM2C_CONFLICT_T
+tm2c_rpc_store_multi(write_entry_t* entries, uint32_t num_entries)
+{
+  TM2C_CONFLICT_T conflict = NO_CONFLICT;
+  uint32_t i, w, pos, remaining, num_addrs = 0;
+  nodeid_t n;
+
+  /* a TYPE_BLOCK entry is locked on every word */
+  for (i = 0; i < num_entries; i++)
+    {
+      num_addrs += WRITE_ENTRY_WORDS(entries + i);
+    }
+
+  if (num_addrs > multi_addrs_size)
+    {
+      free(multi_addrs);
+      multi_addrs_size = 2 * num_addrs;
+      multi_addrs = (tm_intern_addr_t*) malloc(multi_addrs_size * sizeof(tm_intern_addr_t));
+      if (multi_addrs == NULL)
+	{
+	  PRINT("malloc multi_addrs");
+	  EXIT(-1);
+	}
+    }
+
+  /* group (counting sort) the addresses on the responsible node */
+  for (n = 0; n < NUM_DSL_NODES; n++)
+    {
+      multi_end[n] = 0;
+    }
+  for (i = 0; i < num_entries; i++)
+    {
+      uint32_t words = WRITE_ENTRY_WORDS(entries + i);
+      for (w = 0; w < words; w++)
+	{
+	  multi_end[get_responsible_node(entries[i].address + w * WRITE_SET_WORD)]++;
+	}
+    }
+  pos = 0;
+  for (n = 0; n < NUM_DSL_NODES; n++)
+    {
+      multi_next[n] = pos;
+      pos += multi_end[n];
+      multi_end[n] = multi_next[n];
+    }
+  for (i = 0; i < num_entries; i++)
+    {
+      uint32_t words = WRITE_ENTRY_WORDS(entries + i);
+      for (w = 0; w < words; w++)
+	{
+	  tm_intern_addr_t address = entries[i].address + w * WRITE_SET_WORD;
+	  n = get_responsible_node(address);
+	  multi_addrs[multi_end[n]++] = address;
+	}
+    }
+
+  if ((conflict = tm2c_rpc_load_drain_all()) != NO_CONFLICT)
+    {
+      return conflict;
+    }
+
+  remaining = num_addrs;
+  while (remaining > 0 && conflict == NO_CONFLICT)
+    {
+      uint32_t num_round = 0;
+      for (n = 0; n < NUM_DSL_NODES; n++)
+	{
+	  uint32_t num = multi_end[n] - multi_next[n];
+	  if (num == 0)
+	    {
+	      continue;
+	    }
+	  if (num > TM2C_RPC_MULTI_NUM)
+	    {
+	      num = TM2C_RPC_MULTI_NUM;
+	    }
+
+	  nodes_contacted[n] += num;
+	  tm2c_rpc_sendbm(dsl_nodes[n], multi_addrs + multi_next[n], num);
+	  multi_next[n] += num;
+	  remaining -= num;
+	  multi_round[num_round++] = n;
+	}
+
+      for (i = 0; i < num_round; i++)
+	{
+	  n = multi_round[i];
+	  TM2C_CONFLICT_T response = tm2c_rpc_recvb(dsl_nodes[n]);
+	  if (response != NO_CONFLICT)
+	    {
+	      nodes_contacted[n] = 0;
+	      if (conflict == NO_CONFLICT)
+		{
+		  conflict = response;
+		}
+	    }
+	}
+    }
+
+  return conflict;
+}
+#endif	/* !PGAS */
+
 #ifdef PGAS
 
 TM2C_CONFLICT_T
@@ -275,6 +647,11 @@ tm2c_rpc_store_inc(tm_addr_t address, int64_t increment)
 {
   tm_intern_addr_t intern_addr = to_intern_addr(address);
   nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      return response;
+    }
 
   nodes_contacted[responsible_node_seq]++;
   nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
@@ -282,7 +659,7 @@ tm2c_rpc_store_inc(tm_addr_t address, int64_t increment)
   intern_addr &= PGAS_DSL_ADDR_MASK;
   tm2c_rpc_sendbv(responsible_node, TM2C_RPC_STORE_INC, intern_addr, increment);
 
-  TM2C_CONFLICT_T response = tm2c_rpc_recvb(responsible_node);
+  response = tm2c_rpc_recvb(responsible_node);
   if (response != NO_CONFLICT)
     {
       nodes_contacted[responsible_node_seq] = 0;
@@ -292,11 +669,287 @@ tm2c_rpc_store_inc(tm_addr_t address, int64_t increment)
 }
 #endif	/* PGAS */
 
+#if defined(TM2C_RPC_HAS_RMW)
+static inline void
+tm2c_rpc_sendbrmw(nodeid_t target, TM2C_RPC_REQ_TYPE command, tm_intern_addr_t address,
+		  uint32_t rmw, int64_t arg, int64_t arg2)
+{
+  psc->write_value = arg;
+  psc->rmw_arg = arg2;
+  psc->rmw_op = rmw;
+  tm2c_rpc_sendbv(target, command, address, arg);
+}
+
+#  if defined(PGAS)
+TM2C_CONFLICT_T
+tm2c_rpc_rmw(tm_addr_t address, uint32_t rmw, int64_t arg, int64_t arg2)
+{
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      return response;
+    }
+
+  nodes_contacted[responsible_node_seq]++;
+  nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
+
+  intern_addr &= PGAS_DSL_ADDR_MASK;
+  tm2c_rpc_sendbrmw(responsible_node, TM2C_RPC_RMW, intern_addr, rmw, arg, arg2);
+
+  response = tm2c_rpc_recvb(responsible_node);
+  if (response != NO_CONFLICT)
+    {
+      nodes_contacted[responsible_node_seq] = 0;
+    }
+
+  return response;
+}
+#  endif	/* PGAS */
+
+int64_t
+tm2c_rpc_notx_rmw(tm_addr_t address, uint32_t rmw, int64_t arg, int64_t arg2)
+{
+  DSL_DIR_NONTX_START();
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  nodeid_t responsible_node = get_responsible_node(intern_addr);
+  tm2c_rpc_async_drain(responsible_node);
+  responsible_node = dsl_nodes[responsible_node];
+
+#  if defined(PGAS)
+  intern_addr &= PGAS_DSL_ADDR_MASK;
+#  endif	/* PGAS */
+
+  uint32_t retries = 0;
+  while (1)
+    {
+      tm2c_rpc_sendbrmw(responsible_node, TM2C_RPC_RMW_NONTX, intern_addr, rmw, arg, arg2);
+      if (tm2c_rpc_recvb(responsible_node) == NO_CONFLICT)
+	{
+#if defined(TX_PROFILE)
+	  tm2c_profile_forget();	/* not an abort of a tx */
+#endif
+	  break;
+	}
+      wait_cycles(50 * (++retries & 0xFF));
+    }
+  DSL_DIR_NONTX_END();
+  return read_value;
+}
+#endif	/* TM2C_RPC_HAS_RMW */
+
+#if defined(TM2C_RANGE_LOCKS)
+/*
+ * Every DSL node that is responsible for a word of the range gets one
+ * TM2C_RPC_LOAD_RANGE for the whole range. As in tm2c_rpc_store_multi, all
+ * requests are sent before collecting the replies.
+ */
+TM2C_CONFLICT_T
+tm2c_rpc_load_range(tm_addr_t address, size_t len)
+{
+  TM2C_CONFLICT_T conflict = NO_CONFLICT;
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  tm_intern_addr_t a, end = intern_addr + len;
+  uint32_t i, num_round = 0;
+  nodeid_t n;
+
+  /* the words are mapped (and locked by the writers) aligned */
+  for (a = intern_addr & ~((tm_intern_addr_t) TM2C_RANGE_WORD - 1); a < end; a += TM2C_RANGE_WORD)
+    {
+      n = get_responsible_node(a);
+      if (!range_nodes[n])
+	{
+	  range_nodes[n] = 1;
+	  multi_round[num_round++] = n;
+	}
+    }
+
+  for (i = 0; i < num_round; i++)
+    {
+      n = multi_round[i];
+      range_nodes[n] = 0;
+      TM2C_CONFLICT_T response = tm2c_rpc_async_drain(n);
+      if (response != NO_CONFLICT && conflict == NO_CONFLICT)
+	{
+	  conflict = response;
+	}
+    }
+  if (conflict != NO_CONFLICT)
+    {
+      return conflict;
+    }
+
+  for (i = 0; i < num_round; i++)
+    {
+      n = multi_round[i];
+      nodes_contacted[n]++;
+      tm2c_rpc_sendbv(dsl_nodes[n], TM2C_RPC_LOAD_RANGE, intern_addr, len);
+    }
+
+  for (i = 0; i < num_round; i++)
+    {
+      n = multi_round[i];
+      TM2C_CONFLICT_T response = tm2c_rpc_recvb(dsl_nodes[n]);
+      if (response != NO_CONFLICT)
+	{
+	  nodes_contacted[n] = 0;
+	  if (conflict == NO_CONFLICT)
+	    {
+	      conflict = response;
+	    }
+	}
+    }
+
+  return conflict;
+}
+#endif	/* TM2C_RANGE_LOCKS */
+
+#if defined(INVISIBLE_READS)
+/*
+ * Sends a TM2C_RPC_VALIDATE to every contacted node (the DSL keeps the read
+ * log), and then collects the replies.
+ */
+TM2C_CONFLICT_T
+tm2c_rpc_validate(void)
+{
+  TM2C_CONFLICT_T conflict;
+  uint32_t i, num_round = 0;
+  nodeid_t n;
+
+  if ((conflict = tm2c_rpc_load_drain_all()) != NO_CONFLICT)
+    {
+      return conflict;
+    }
+
+  for (n = 0; n < NUM_DSL_NODES; n++)
+    {
+      if (nodes_contacted[n] > 0)
+	{
+	  tm2c_rpc_sendb(dsl_nodes[n], TM2C_RPC_VALIDATE, 0);
+	  multi_round[num_round++] = n;
+	}
+    }
+
+  for (i = 0; i < num_round; i++)
+    {
+      n = multi_round[i];
+      TM2C_CONFLICT_T response = tm2c_rpc_recvb(dsl_nodes[n]);
+      if (response != NO_CONFLICT)
+	{
+	  nodes_contacted[n] = 0;
+	  if (conflict == NO_CONFLICT)
+	    {
+	      conflict = response;
+	    }
+	}
+    }
+
+  return conflict;
+}
+#endif	/* INVISIBLE_READS */
+
+TM2C_CONFLICT_T
+tm2c_rpc_load_async(tm_addr_t address, int words)
+{
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+
+  /* only one outstanding request per node: complete the previous one */
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      return response;
+    }
+
+  async_pending[responsible_node_seq] = 1;
+  async_addr[responsible_node_seq] = intern_addr;
+  async_num_pending++;
+
+  nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
+#if defined(PGAS_MVCC)
+  if (tm2c_tx->snapshot)
+    {
+      intern_addr &= PGAS_DSL_ADDR_MASK;
+      tm2c_rpc_sendbv(responsible_node, TM2C_RPC_LOAD_SNAPSHOT, intern_addr,
+		      PGAS_MVCC_PACK(tm2c_tx->snapshot, words));
+      return NO_CONFLICT;
+    }
+#endif	/* PGAS_MVCC */
+
+  nodes_contacted[responsible_node_seq]++;
+#ifdef PGAS
+  intern_addr &= PGAS_DSL_ADDR_MASK;
+  tm2c_rpc_sendbv(responsible_node, TM2C_RPC_LOAD, intern_addr, words);
+#else
+  tm2c_rpc_sendb(responsible_node, TM2C_RPC_LOAD, intern_addr);
+#endif
+
+  return NO_CONFLICT;
+}
+
+TM2C_CONFLICT_T
+tm2c_rpc_load_wait(tm_addr_t address, int words)
+{
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+
+  if (async_pending[responsible_node_seq] && async_addr[responsible_node_seq] == intern_addr)
+    {
+      return tm2c_rpc_async_collect(responsible_node_seq, 0);
+    }
+
+  /* already collected: waits usually come in the order of the async loads,
+     so start looking after the last match */
+  uint32_t i;
+  for (i = 0; i < async_done_nb; i++)
+    {
+      uint32_t idx = async_done_cur + i;
+      if (idx >= async_done_nb)
+	{
+	  idx -= async_done_nb;
+	}
+
+      if (async_done[idx].address == intern_addr)
+	{
+	  async_done_cur = idx + 1;
+#ifdef PGAS
+	  read_value = async_done[idx].value;
+#endif
+	  return NO_CONFLICT;
+	}
+    }
+
+  /* no async load was issued for this address */
+  return tm2c_rpc_load(address, words);
+}
+
+TM2C_CONFLICT_T
+tm2c_rpc_load_drain_all(void)
+{
+  TM2C_CONFLICT_T conflict = NO_CONFLICT;
+  nodeid_t n;
+  for (n = 0; async_num_pending > 0 && n < NUM_DSL_NODES; n++)
+    {
+      if (async_pending[n])
+	{
+	  TM2C_CONFLICT_T response = tm2c_rpc_async_collect(n, 1);
+	  if (conflict == NO_CONFLICT)
+	    {
+	      conflict = response;
+	    }
+	}
+    }
+  return conflict;
+}
+
 uint64_t
 tm2c_rpc_notx_load(tm_addr_t address, int words) 
 {
+  DSL_DIR_NONTX_START();
   tm_intern_addr_t intern_addr = to_intern_addr(address);
   nodeid_t responsible_node = get_responsible_node(intern_addr);
+  tm2c_rpc_async_drain(responsible_node);
   responsible_node = dsl_nodes[responsible_node];
 
 #if defined(PGAS)
@@ -305,6 +958,7 @@ tm2c_rpc_notx_load(tm_addr_t address, int words)
 
   tm2c_rpc_sendbr(responsible_node, TM2C_RPC_LOAD_NONTX, intern_addr, words);
   tm2c_rpc_recvb(responsible_node);
+  DSL_DIR_NONTX_END();
 
   return read_value;
 }
@@ -312,6 +966,7 @@ tm2c_rpc_notx_load(tm_addr_t address, int words)
 void
 tm2c_rpc_notx_store(tm_addr_t address, int64_t value) 
 {
+  DSL_DIR_NONTX_START();
   tm_intern_addr_t intern_addr = to_intern_addr(address);
   nodeid_t responsible_node = get_responsible_node(intern_addr);
   responsible_node = dsl_nodes[responsible_node];
@@ -321,6 +976,7 @@ tm2c_rpc_notx_store(tm_addr_t address, int64_t value)
 #endif	/* PGAS */
 
   tm2c_rpc_sendbv(responsible_node, TM2C_RPC_STORE_NONTX, intern_addr, value);
+  DSL_DIR_NONTX_END();
 }
 
 void
@@ -332,7 +988,15 @@ tm2c_rpc_load_rls(tm_addr_t address)
   intern_addr &= PGAS_DSL_ADDR_MASK;
 #endif	/* PGAS */
 
-  nodes_contacted[responsible_node]--;
+  if (nodes_contacted[responsible_node] == 0)
+    {
+      return;			/* nothing held on the node */
+    }
+  /* not acknowledged: the node is released at commit anyway */
+  if (nodes_contacted[responsible_node] > 1)
+    {
+      nodes_contacted[responsible_node]--;
+    }
   responsible_node = dsl_nodes[responsible_node];
 
   tm2c_rpc_sendb(responsible_node, TM2C_RPC_LOAD_RLS, intern_addr);
@@ -344,20 +1008,115 @@ tm2c_rpc_store_rls(tm_addr_t address)
   tm_intern_addr_t intern_addr = to_intern_addr(address);
   nodeid_t responsible_node = get_responsible_node(intern_addr);
 
+#if defined(PGAS_FUSED_STORE)
+  TM2C_CONFLICT_T conflict;
+  if ((conflict = tm2c_rpc_async_drain(responsible_node)) != NO_CONFLICT)
+    {
+      TX_ABORT(conflict);
+    }
+#endif	/* PGAS_FUSED_STORE */
+
 #if defined(PGAS)
   intern_addr &= PGAS_DSL_ADDR_MASK;
 #endif	/* PGAS */
 
-  nodes_contacted[responsible_node]--;
+  if (nodes_contacted[responsible_node] > 1)
+    {
+      nodes_contacted[responsible_node]--;
+    }
   responsible_node = dsl_nodes[responsible_node];
 
   tm2c_rpc_sendb(responsible_node, TM2C_RPC_STORE_FINISH, intern_addr);
 }
 
+void
+tm2c_rpc_release(tm_addr_t address)
+{
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+  if (nodes_contacted[responsible_node_seq] == 0)
+    {
+      return;			/* nothing held on the node */
+    }
+
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      TX_ABORT(response);
+    }
+
+#if defined(PGAS)
+  intern_addr &= PGAS_DSL_ADDR_MASK;
+#endif	/* PGAS */
+
+  nodeid_t responsible_node = dsl_nodes[responsible_node_seq];
+  tm2c_rpc_sendb(responsible_node, TM2C_RPC_RELEASE, intern_addr);
+
+  /* the response is whether the node still holds any lock of the tx (not
+     a conflict, thus not tm2c_rpc_recvb) */
+  TM2C_RPC_REPLY cmd;
+  sys_recvcmd(&cmd, sizeof (TM2C_RPC_REPLY), responsible_node);
+  if (cmd.response == FALSE)
+    {
+      nodes_contacted[responsible_node_seq] = 0;
+    }
+}
+
+void
+tm2c_rpc_downgrade(tm_addr_t address)
+{
+  tm_intern_addr_t intern_addr = to_intern_addr(address);
+  nodeid_t responsible_node_seq = get_responsible_node(intern_addr);
+
+  TM2C_CONFLICT_T response = tm2c_rpc_async_drain(responsible_node_seq);
+  if (response != NO_CONFLICT)
+    {
+      TX_ABORT(response);
+    }
+  if (nodes_contacted[responsible_node_seq] == 0)
+    {
+      return;			/* no write lock on the node */
+    }
+
+#if defined(PGAS)
+  intern_addr &= PGAS_DSL_ADDR_MASK;
+#endif	/* PGAS */
+
+  /* the sender keeps (at least) the read lock: nodes_contacted is intact */
+  tm2c_rpc_sendb(dsl_nodes[responsible_node_seq], TM2C_RPC_DOWNGRADE, intern_addr);
+}
+
 void 
 tm2c_rpc_rls_all(TM2C_CONFLICT_T conflict) 
 {
+  /* replies of async loads that were never waited for */
+  tm2c_rpc_load_drain_all();
+  async_done_nb = 0;
+  async_done_cur = 0;
+
+#if defined(PGAS_FUSED_STORE)
+  if (store_pending)
+    {
+      if (conflict != NO_CONFLICT)
+	{
+	  store_pending = 0;	/* never sent */
+	}
+      else
+	{
+	  nodeid_t node_seq = store_pending_node;
+	  TM2C_CONFLICT_T response = tm2c_rpc_store_pending_send(TM2C_RPC_STORE_COMMIT);
+	  if (response != NO_CONFLICT)
+	    {
+	      TX_ABORT(response);
+	    }
+	  nodes_contacted[node_seq] = 0; /* persisted and released */
+	}
+    }
+#endif	/* PGAS_FUSED_STORE */
+
 #if defined(PGAS)
+  /* the DSL nodes persist the writes: the tx is durable once they have
+     processed the TM2C_RPC_RMV_NODE */
   nodeid_t i;
   for (i = 0; i < NUM_DSL_NODES; i++) 
     {
@@ -399,6 +1158,7 @@ tm2c_rpc_rls_all(TM2C_CONFLICT_T conflict)
 #endif
 }
 
+
 void
 tm2c_rpc_stats(tm2c_tx_node_t* stats, double duration)
 {
@@ -414,6 +1174,14 @@ tm2c_rpc_stats(tm2c_tx_node_t* stats, double duration)
       duration = 1;		/* to make stats work properly */
     }
 
+  /* before the stats: the first DSL node prints with the stats */
+#if defined(TX_PROFILE)
+  tm2c_profile_send();
+#endif
+#if defined(TX_HISTO)
+  tm2c_histo_send();
+#endif
+
   stats_cmd->type = TM2C_RPC_STATS;
   stats_cmd->nodeId = NODE_ID();
 
@@ -431,13 +1199,77 @@ tm2c_rpc_stats(tm2c_tx_node_t* stats, double duration)
     
   sys_sendcmd_all(stats_cmd, sizeof(TM2C_RPC_STATS_T));
 
+#if defined(STATS_EXPORT)
+  tm2c_stats_app(stats, duration);
+#endif
+
   BARRIERW;
   free(stats_cmd);
 }
 
+#if defined(TX_NESTING) && !defined(PGAS)
+void
+tm2c_rpc_savepoint(unsigned short* contacted)
+{
+  memcpy(contacted, nodes_contacted, NUM_DSL_NODES * sizeof(unsigned short));
+}
+
+/* a DSL node that replies with a conflict drops all the locks of the tx on
+   it (and nodes_contacted of it is reset): the locks of the enclosing
+   blocks are intact if they had not contacted such a node */
+uint32_t
+tm2c_rpc_rollback(unsigned short* contacted)
+{
+  tm2c_rpc_load_drain_all();
+  /* the kept replies might be of nodes that dropped the locks */
+  async_done_nb = 0;
+  async_done_cur = 0;
+
+  nodeid_t n;
+  for (n = 0; n < NUM_DSL_NODES; n++)
+    {
+      if (contacted[n] > 0 && nodes_contacted[n] == 0)
+	{
+	  return FALSE;
+	}
+    }
+  return TRUE;
+}
+#endif	/* TX_NESTING */
+
+#if defined(IRREVOCABLE)
+/* nothing is pending at the start of a tx: the requests of the last try
+   were released */
+void
+tm2c_rpc_irrevoc()
+{
+  nodeid_t token_node = dsl_nodes[0];
+  uint32_t retries = 0;
+  while (1)
+    {
+      tm2c_rpc_sendb(token_node, TM2C_RPC_IRREVOC, 0);
+      if (tm2c_rpc_recvb(token_node) == NO_CONFLICT)
+	{
+#if defined(TX_PROFILE)
+	  tm2c_profile_forget();	/* not an abort of a tx */
+#endif
+	  return;
+	}
+      wait_cycles(50 * (++retries & 0xFF));
+    }
+}
+
+void
+tm2c_rpc_irrevoc_rls()
+{
+  tm2c_rpc_sendb(dsl_nodes[0], TM2C_RPC_IRREVOC_RLS, 0);
+}
+#endif	/* IRREVOCABLE */
+
 TM2C_CONFLICT_T
 tm2c_rpc_dummy(nodeid_t node)
 {
+  tm2c_rpc_async_drain(node);
   node = dsl_nodes[node];
   tm2c_rpc_sendb(node, TM2C_RPC_UKNOWN, 0);
   TM2C_CONFLICT_T response = tm2c_rpc_recvb(node);
@@ -449,11 +1281,28 @@ get_responsible_node(tm_intern_addr_t addr)
 {
 #if defined(PGAS)
   return addr >> PGAS_DSL_MASK_BITS;
+#elif defined(DSL_NODE_WORKERS)
+  /* the node is selected as usual (over the DSL nodes, not the dsl cores),
+     the worker with an independent (multiplicative) hash of the word */
+#  if (ADDR_TO_DSL_SEL == 0)
+  nodeid_t node = hash_tw(addr >> ADDR_SHIFT_MASK) % DSL_NUM_PARTITIONS;
+#  elif (ADDR_TO_DSL_SEL == 1)
+  nodeid_t node = ((addr) >> ADDR_SHIFT_MASK) % DSL_NUM_PARTITIONS;
+#  elif (ADDR_TO_DSL_SEL == 2)
+  nodeid_t node = dsl_dir_node(addr);
+#  endif
+  if (dsl_node_workers[node] == 1)
+    {
+      return dsl_node_first[node];
+    }
+  return dsl_node_first[node] + hash_32((uint32_t) (addr >> 2), 16) % dsl_node_workers[node];
 #else	 /* !PGAS */
 #  if (ADDR_TO_DSL_SEL == 0)
   return hash_tw(addr >> ADDR_SHIFT_MASK) % NUM_DSL_NODES;
 #  elif (ADDR_TO_DSL_SEL == 1)
   return ((addr) >> ADDR_SHIFT_MASK) % NUM_DSL_NODES;
+#  elif (ADDR_TO_DSL_SEL == 2)
+  return dsl_dir_node(addr);
 #  endif
 #endif	/* PGAS */
 }
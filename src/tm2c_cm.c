@@ -33,24 +33,34 @@ extern tm2c_ht_t tm2c_ht;
 #include "tm2c_log.h"
 extern tm2c_write_set_pgas_t** PGAS_write_sets;
 #endif
+#if defined(IRREVOCABLE)
+#include "tm2c_irrevoc.h"
+#endif
+
+/* aborts defender, that lost a conflict, and drops what it holds here */
+static inline void
+cm_abort_defender(nodeid_t defender, TM2C_CONFLICT_T conflict)
+{
+#if defined(PGAS)
+  if (abort_node_is_persisting((uint32_t) defender, conflict))
+    {
+      write_set_pgas_persist(PGAS_write_sets[defender]);
+    }
+  write_set_pgas_empty(PGAS_write_sets[defender]);
+#else
+  abort_node((uint32_t) defender, conflict);
+  tm2c_ht_delete_node(tm2c_ht, defender);
+#endif	/* PGAS */
+}
 
 inline BOOLEAN 
-contention_manager_raw_waw(nodeid_t attacker, uint16_t defender, TM2C_CONFLICT_T conflict) 
+cm_priority_raw_waw(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict) 
 {
   if (cm_metadata_core[attacker].timestamp < cm_metadata_core[defender].timestamp ||
       (cm_metadata_core[attacker].timestamp == cm_metadata_core[defender].timestamp && attacker < defender)) 
     {
       //new TX - attacker won
-#if defined(PGAS)
-      if (abort_node_is_persisting((uint32_t) defender, conflict))
-	{
-	  write_set_pgas_persist(PGAS_write_sets[defender]);
-	}
-      write_set_pgas_empty(PGAS_write_sets[defender]);
-#else
-      abort_node((uint32_t) defender, conflict);
-      tm2c_ht_delete_node(tm2c_ht, defender);
-#endif	/* PGAS */
+      cm_abort_defender(defender, conflict);
       return TRUE;
     } 
   else 				/* existing TX won */
@@ -62,41 +72,75 @@ contention_manager_raw_waw(nodeid_t attacker, uint16_t defender, TM2C_CONFLICT_T
 }
 
 inline BOOLEAN 
-contention_manager_war(nodeid_t attacker, uint8_t* defenders, TM2C_CONFLICT_T conflict)
+cm_priority_war(nodeid_t attacker, nodeid_t* defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict)
 {
-  nodeid_t defender;
-  for (defender = 0; defender < NUM_UES; defender++)
+  uint32_t i;
+  for (i = 0; i < num_defenders; i++)
     {
-      if (defenders[defender])
+      nodeid_t defender = defenders[i];
+      if (cm_metadata_core[attacker].timestamp > cm_metadata_core[defender].timestamp ||
+	  (cm_metadata_core[attacker].timestamp == cm_metadata_core[defender].timestamp && defender < attacker))
 	{
-	  if (cm_metadata_core[attacker].timestamp > cm_metadata_core[defender].timestamp ||
-	      (cm_metadata_core[attacker].timestamp == cm_metadata_core[defender].timestamp && defender < attacker))
-	    {
-	      return FALSE;
-	    }
+	  return FALSE;
 	}
     }
   //attacker won all readers
-  for (defender = 0; defender < NUM_UES; defender++)
+  for (i = 0; i < num_defenders; i++)
     {
-      if (defenders[defender] && defender != attacker)
+      nodeid_t defender = defenders[i];
+      if (defender != attacker)
 	{
-#if defined(PGAS)
-	  if (abort_node_is_persisting((uint32_t) defender, conflict))
-	    {
-	      write_set_pgas_persist(PGAS_write_sets[defender]);
-	    }
-	  write_set_pgas_empty(PGAS_write_sets[defender]);
-#else
-      abort_node((unsigned int) defender, conflict);
-      tm2c_ht_delete_node(tm2c_ht, defender);
-#endif	/* PGAS */
+	  cm_abort_defender(defender, conflict);
 	}
     }
 
   return TRUE;
 }
 
+#if defined(IRREVOCABLE)
+/* the owner of the irrevocability token wins, else as the contention
+   manager */
+BOOLEAN
+cm_irrevoc_raw_waw(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict)
+{
+  if (tm2c_irrevoc_is_owner(defender))
+    {
+      return FALSE;
+    }
+  if (tm2c_irrevoc_is_owner(attacker))
+    {
+      cm_abort_defender(defender, conflict);
+      return TRUE;
+    }
+  return cm_resolve_raw_waw(attacker, defender, conflict);
+}
+
+BOOLEAN
+cm_irrevoc_war(nodeid_t attacker, nodeid_t* defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict)
+{
+  uint32_t i;
+  if (tm2c_irrevoc_is_owner(attacker))
+    {
+      for (i = 0; i < num_defenders; i++)
+	{
+	  if (defenders[i] != attacker)
+	    {
+	      cm_abort_defender(defenders[i], conflict);
+	    }
+	}
+      return TRUE;
+    }
+  for (i = 0; i < num_defenders; i++)
+    {
+      if (tm2c_irrevoc_is_owner(defenders[i]))
+	{
+	  return FALSE;
+	}
+    }
+  return cm_resolve_war(attacker, defenders, num_defenders, conflict);
+}
+#endif	/* IRREVOCABLE */
+
 void
 contention_manager_pri_print() 
 {
@@ -216,4 +260,234 @@ contention_manager(nodeid_t attacker, unsigned short *defenders, TM2C_CONFLICT_T
   return FALSE;
 }
 
+#if defined(DYNAMIC_CM)
+#include <strings.h>
+#include "tm2c.h"
+
+static void
+cm_no_op()
+{
+}
+
+static uint64_t
+cm_no_tx_metadata()
+{
+  return 0;
+}
+
+static uint64_t
+cm_wholly_tx_metadata()
+{
+  return tm2c_tx_node->tx_committed;
+}
+
+static uint64_t
+cm_greedy_tx_metadata()
+{
+  return getticks() - tm2c_tx->start_ts;
+}
+
+static void
+cm_greedy_on_first_start()
+{
+  tm2c_tx->start_ts = getticks();
+}
+
+static uint64_t
+cm_faircm_tx_metadata()
+{
+  return tm2c_tx_node->tx_duration;
+}
+
+static void
+cm_faircm_on_start()
+{
+  tm2c_tx->start_ts = getticks();
+}
+
+static void
+cm_faircm_on_commit()
+{
+  tm2c_tx_node->tx_duration += (getticks() - tm2c_tx->start_ts);
+}
+
+/* exponentially increasing random backoff, as with BACKOFF_RETRY */
+static void
+cm_backoff_on_abort()
+{
+  if (BACKOFF_MAX > 0)  
+    {
+      uint32_t wait_exp = tm2c_tx->retries;
+      if (wait_exp > BACKOFF_MAX)
+	{
+	  wait_exp = BACKOFF_MAX;
+	}
+
+      uint32_t wait_max = BACKOFF_DELAY;
+      wait_max <<= (wait_exp - 1);
+
+      ndelay(tm2c_rand() % wait_max);
+    }
+}
+
+static void
+cm_wait_on_abort()
+{
+  wait_cycles(50 * (tm2c_tx->retries & 0xFF));
+}
+
+static void
+cm_no_priority(nodeid_t sender, uint64_t tx_metadata)
+{
+}
+
+/* wholly, faircm: the latest value of the sender */
+static void
+cm_set_priority(nodeid_t sender, uint64_t tx_metadata)
+{
+  cm_metadata_core[sender].timestamp = (ticks) tx_metadata;
+}
+
+/* greedy: the (offset-based) start of the tx, until it is reset to 0 at its
+   end on this node */
+static void
+cm_greedy_priority(nodeid_t sender, uint64_t tx_metadata)
+{
+  if (cm_metadata_core[sender].timestamp == 0)
+    {
+      cm_metadata_core[sender].timestamp = getticks() - (ticks) tx_metadata;
+    }
+}
+
+/* nocm, backoff_retry: the attacker always loses */
+static BOOLEAN
+cm_none_raw_waw(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict)
+{
+  return FALSE;
+}
+
+static BOOLEAN
+cm_none_war(nodeid_t attacker, nodeid_t* defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict)
+{
+  return FALSE;
+}
+
+/* the adaptive cm state of this DSL core */
+static struct
+{
+  uint32_t priority;		/* resolving as greedy */
+  uint32_t txs;			/* in the current window */
+  uint32_t conflicts;		/* in the current window */
+  uint32_t escalations;
+  uint32_t fallbacks;
+} cm_adaptive;
+
+/* a tx of sender contacts this node for the first time (the greedy
+   timestamp is reset to 0 at its end) */
+static void
+cm_adaptive_priority(nodeid_t sender, uint64_t tx_metadata)
+{
+  if (cm_metadata_core[sender].timestamp != 0)
+    {
+      return;
+    }
+  cm_metadata_core[sender].timestamp = getticks() - (ticks) tx_metadata;
+
+  if (++cm_adaptive.txs < ADAPTIVE_CM_WINDOW)
+    {
+      return;
+    }
+
+  uint32_t pct = (100 * cm_adaptive.conflicts) / cm_adaptive.txs;
+  if (!cm_adaptive.priority && pct >= ADAPTIVE_CM_HIGH)
+    {
+      cm_adaptive.priority = 1;
+      cm_adaptive.escalations++;
+    }
+  else if (cm_adaptive.priority && pct < ADAPTIVE_CM_LOW)
+    {
+      cm_adaptive.priority = 0;
+      cm_adaptive.fallbacks++;
+    }
+  cm_adaptive.txs = 0;
+  cm_adaptive.conflicts = 0;
+}
+
+static BOOLEAN
+cm_adaptive_raw_waw(nodeid_t attacker, nodeid_t defender, TM2C_CONFLICT_T conflict)
+{
+  cm_adaptive.conflicts++;
+  if (cm_adaptive.priority)
+    {
+      return cm_priority_raw_waw(attacker, defender, conflict);
+    }
+  return FALSE;
+}
+
+static BOOLEAN
+cm_adaptive_war(nodeid_t attacker, nodeid_t* defenders, uint32_t num_defenders, TM2C_CONFLICT_T conflict)
+{
+  cm_adaptive.conflicts++;
+  if (cm_adaptive.priority)
+    {
+      return cm_priority_war(attacker, defenders, num_defenders, conflict);
+    }
+  return FALSE;
+}
+
+static const tm2c_cm_ops_t cm_ops[] =
+  {
+    { "nocm", cm_no_tx_metadata, cm_no_op, cm_no_op, cm_no_op, cm_wait_on_abort,
+      cm_no_priority, cm_none_raw_waw, cm_none_war },
+    { "backoff_retry", cm_no_tx_metadata, cm_no_op, cm_no_op, cm_no_op, cm_backoff_on_abort,
+      cm_no_priority, cm_none_raw_waw, cm_none_war },
+    { "wholly", cm_wholly_tx_metadata, cm_no_op, cm_no_op, cm_no_op, cm_wait_on_abort,
+      cm_set_priority, cm_priority_raw_waw, cm_priority_war },
+    { "greedy", cm_greedy_tx_metadata, cm_greedy_on_first_start, cm_no_op, cm_no_op, cm_wait_on_abort,
+      cm_greedy_priority, cm_priority_raw_waw, cm_priority_war },
+    { "faircm", cm_faircm_tx_metadata, cm_no_op, cm_faircm_on_start, cm_faircm_on_commit, cm_wait_on_abort,
+      cm_set_priority, cm_priority_raw_waw, cm_priority_war },
+    { "adaptive", cm_greedy_tx_metadata, cm_greedy_on_first_start, cm_no_op, cm_no_op, cm_backoff_on_abort,
+      cm_adaptive_priority, cm_adaptive_raw_waw, cm_adaptive_war },
+  };
+
+#define CM_OPS_NUM (sizeof(cm_ops) / sizeof(cm_ops[0]))
+
+/* the default of settings */
+const tm2c_cm_ops_t* tm2c_cm = &cm_ops[1];
+
+void
+tm2c_cm_select(const char* name)
+{
+  uint32_t i;
+  for (i = 0; i < CM_OPS_NUM; i++)
+    {
+      if (strcasecmp(name, cm_ops[i].name) == 0)
+	{
+	  tm2c_cm = &cm_ops[i];
+	  return;
+	}
+    }
+
+  fprintf(stderr, "Unknown contention manager: %s\n", name);
+  fprintf(stderr, "Use one of:");
+  for (i = 0; i < CM_OPS_NUM; i++)
+    {
+      fprintf(stderr, " %s", cm_ops[i].name);
+    }
+  fprintf(stderr, "\n");
+  EXIT(1);
+}
+
+void
+tm2c_cm_term()
+{
+  if (cm_adaptive.escalations > 0)
+    {
+      printf("[%02d] adaptive CM: %u escalations to greedy, %u fallbacks to backoff_retry\n",
+	     NODE_ID(), cm_adaptive.escalations, cm_adaptive.fallbacks);
+    }
+}
+#endif	/* DYNAMIC_CM */
+
 #endif	/* NOCM */
@@ -87,12 +87,18 @@ tm2c_dsl_init(void)
 	      PRINT("malloc PGAS_write_sets[i] == NULL");
 	      EXIT(-1);
 	    }
+#if defined(PGAS_MVCC)
+	  PGAS_write_sets[j]->owner = j;
+#endif	/* PGAS_MVCC */
 	}
     }
 
 #endif
 
   tm2c_ht = tm2c_ht_new();
+#if defined(DSL_WAITQ)
+  dsl_waitq_init();
+#endif
 
 #if !defined(NOCM) && !defined(BACKOFF_RETRY) /* if any other CM (greedy, wholly, faircm) */
   cm_metadata_core = (cm_metadata_t *) calloc(NUM_UES, sizeof(cm_metadata_t));
@@ -169,6 +175,12 @@ tm2c_dsl_print_global_stats()
       printf("NA| Aborts WAR  \t: %lu\t/s\n", tm2c_stats_aborts_war);
       printf("NA| Aborts RAW  \t: %lu\t/s\n", tm2c_stats_aborts_raw);
       printf("NA| Aborts WAW  \t: %lu\t/s\n", tm2c_stats_aborts_waw);
+#if defined(TX_PROFILE)
+      tm2c_profile_print();
+#endif
+#if defined(TX_HISTO)
+      tm2c_histo_print();
+#endif
       printf(":: Collect data ----------------------------------------------\n");
       printf("))) %-10lu%-7.2f%-.3f%5d\t(Throughput, Commit Rate, Latency)\n", tm2c_stats_commits_total, commit_rate * 100, tx_latency, NUM_DSL_NODES);
       printf("||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||\n");
@@ -30,6 +30,8 @@ extern "C" {
 #include "tm2c_dsl_ht.h"
 #include "hash.h"
 #include "common.h"
+#include "dsl_dir.h"
+#include "tm2c_profile.h"
 
   /*
    * ===========================================================================
@@ -37,9 +39,46 @@ extern "C" {
    * ===========================================================================
    */
 
-#if USE_HASHTABLE_SSHT /************************************************************* SSHT ***/
+#if USE_HASHTABLE_SSHT || USE_HASHTABLE_OAHT /********************************* SSHT / OAHT ***/
 
+  /*
+   * Both hashtables keep ssht_rw_entry_t entries and use the ssht logs: only
+   * the primitives that find, insert, and remove the entry of an address
+   * differ (TM2C_HT_* below).
+   */
   ssht_log_set_t** logs;
+#if defined(INVISIBLE_READS)
+  typedef struct tm2c_ht_read_entry
+  {
+    tm_intern_addr_t address;
+    uint32_t version;
+  } tm2c_ht_read_entry_t;
+
+  typedef struct tm2c_ht_read_log
+  {
+    tm2c_ht_read_entry_t* entries;
+    uint32_t nb_entries;
+    uint32_t size;
+  } tm2c_ht_read_log_t;
+
+  tm2c_ht_read_log_t* read_logs;
+  uint32_t* versions;
+
+#  define TM2C_HT_VERSION(addr)						\
+  versions[tm2c_ht_get_hash(addr) & (TM2C_HT_VERSION_STRIPES - 1)]
+#endif	/* INVISIBLE_READS */
+
+#if defined(TM2C_RANGE_LOCKS)
+  /* number of log entries for range keys: writers need to look for range
+     readers only when there are any. Per node, they are dropped all at once
+     by tm2c_ht_delete_node (also those released earlier) */
+  uint32_t range_log_entries = 0;
+  static uint32_t* range_node_entries;
+#  if defined(TX_PROFILE)
+  /* the word of the last range that conflicted (the reply has the start) */
+  static tm_intern_addr_t range_conflict = 0;
+#  endif
+#endif	/* TM2C_RANGE_LOCKS */
 
   static inline uint32_t
   tm2c_ht_get_hash(uintptr_t address)
@@ -47,6 +86,32 @@ extern "C" {
     return hash_tw((address>>3));
   }
 
+#if USE_HASHTABLE_SSHT
+  static inline uint32_t
+  tm2c_ht_bucket(tm_intern_addr_t address)
+  {
+#  ifdef PGAS
+    return (address) & NUM_OF_BUCKETS_2;
+#  else  /* !PGAS */
+    return tm2c_ht_get_hash(address) & NUM_OF_BUCKETS_2;
+#  endif	/* PGAS */
+  }
+
+#  define TM2C_HT_NEW()                            ssht_new()
+#  define TM2C_HT_FREE(ht)                         ssht_free((ssht_hashtable_t*) (ht))
+#  define TM2C_HT_LOOKUP(ht, addr)                 bucket_lookup((ht) + tm2c_ht_bucket(addr), (addr))
+#  define TM2C_HT_INSERT(ht, log, node, addr, rw)  ssht_insert((ht), tm2c_ht_bucket(addr), (log), (node), (addr), (rw))
+#  define TM2C_HT_REMOVE(ht, node, e, rw)          ssht_remove((node), (e), (rw))
+#  define TM2C_HT_REMOVE_ANY(ht, le, node)         ssht_remove_any((le)->address, (node), (le)->entry)
+#else  /* USE_HASHTABLE_OAHT */
+#  define TM2C_HT_NEW()                            oaht_new()
+#  define TM2C_HT_FREE(ht)                         oaht_free(ht)
+#  define TM2C_HT_LOOKUP(ht, addr)                 oaht_lookup((ht), (addr))
+#  define TM2C_HT_INSERT(ht, log, node, addr, rw)  oaht_insert((ht), (log), (node), (addr), (rw))
+#  define TM2C_HT_REMOVE(ht, node, e, rw)          oaht_remove((ht), (node), (e), (rw))
+#  define TM2C_HT_REMOVE_ANY(ht, le, node)         oaht_remove_any((ht), (node), (le)->entry)
+#endif	/* USE_HASHTABLE_SSHT */
+
 
   tm2c_ht_t
   tm2c_ht_new()
@@ -63,7 +128,17 @@ extern "C" {
 	  }
       }
 
-    return ssht_new();
+#if defined(INVISIBLE_READS)
+    read_logs = (tm2c_ht_read_log_t*) calloc(NUM_UES, sizeof(tm2c_ht_read_log_t));
+    versions = (uint32_t*) calloc(TM2C_HT_VERSION_STRIPES, sizeof(uint32_t));
+    assert(read_logs != NULL && versions != NULL);
+#endif	/* INVISIBLE_READS */
+#if defined(TM2C_RANGE_LOCKS)
+    range_node_entries = (uint32_t*) calloc(NUM_UES, sizeof(uint32_t));
+    assert(range_node_entries != NULL);
+#endif	/* TM2C_RANGE_LOCKS */
+
+    return TM2C_HT_NEW();
   }
 
   void
@@ -75,29 +150,302 @@ extern "C" {
 	if (is_app_core(i))
 	  {
 	    free(logs[i]);
+#if defined(INVISIBLE_READS)
+	    free(read_logs[i].entries);
+#endif	/* INVISIBLE_READS */
+	  }
+      }
+#if defined(INVISIBLE_READS)
+    free(read_logs);
+    free(versions);
+#endif	/* INVISIBLE_READS */
+#if defined(TM2C_RANGE_LOCKS)
+    free(range_node_entries);
+#endif	/* TM2C_RANGE_LOCKS */
+
+    TM2C_HT_FREE(ht);
+  }
+
+#if defined(TM2C_RANGE_LOCKS)
+  /* 
+   * a writer of address conflicts with the (other) readers of the range key
+   * of address 
+   */
+  static inline TM2C_CONFLICT_T
+  tm2c_ht_check_range_readers(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t address)
+  {
+    tm_intern_addr_t key = TM2C_RANGE_KEY(address);
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, key);
+    if (e == NULL)
+      {
+	return NO_CONFLICT;
+      }
+
+    if (ssht_rw_entry_has_other_readers(e, node_id))
+      {
+#  if !defined(NOCM) && !defined(BACKOFF_RETRY) 	/* if any other CM (greedy, wholly, faircm) */
+	nodeid_t readers[MAX_READERS];
+	uint32_t num_readers = ssht_rw_entry_fetch_readers(e, readers);
+	if (!contention_manager_war(node_id, readers, num_readers, WRITE_AFTER_READ))
+	  {
+	    return WRITE_AFTER_READ;
+	  }
+#  else
+	return WRITE_AFTER_READ;
+#  endif	/* NOCM */
+      }
+
+    return NO_CONFLICT;
+  }
+#endif	/* TM2C_RANGE_LOCKS */
+
+#if defined(INVISIBLE_READS)
+  static inline void
+  tm2c_ht_read_log_add(nodeid_t node_id, tm_intern_addr_t address)
+  {
+    tm2c_ht_read_log_t* log = read_logs + node_id;
+    if (log->nb_entries == log->size)
+      {
+	log->size = (log->size == 0) ? SSHT_LOG_SET_SIZE : 2 * log->size;
+	log->entries = (tm2c_ht_read_entry_t*) realloc(log->entries, log->size * sizeof(tm2c_ht_read_entry_t));
+	assert(log->entries != NULL);
+      }
+    log->entries[log->nb_entries].address = address;
+    log->entries[log->nb_entries].version = TM2C_HT_VERSION(address);
+    log->nb_entries++;
+  }
+
+  static inline TM2C_CONFLICT_T
+  tm2c_ht_insert_invisible(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t address)
+  {
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+    if (e != NULL && e->writer != SSHT_NO_WRITER && e->writer != node_id)
+      {
+#  if !defined(NOCM) && !defined(BACKOFF_RETRY) 	/* if any other CM (greedy, wholly, faircm) */
+	if (!contention_manager_raw_waw(node_id, (uint16_t) e->writer, READ_AFTER_WRITE)) 
+	  {
+	    return READ_AFTER_WRITE;
 	  }
+#  else
+	return READ_AFTER_WRITE;
+#  endif	/* NOCM */
       }
 
-    ssht_free((ssht_hashtable_t*) ht);
+    tm2c_ht_read_log_add(node_id, address);
+    return NO_CONFLICT;
   }
 
+  TM2C_CONFLICT_T
+  tm2c_ht_validate(tm2c_ht_t tm2c_ht, nodeid_t node_id)
+  {
+    tm2c_ht_read_log_t* log = read_logs + node_id;
+    uint32_t j;
+    for (j = 0; j < log->nb_entries; j++)
+      {
+	tm_intern_addr_t address = log->entries[j].address;
+	if (log->entries[j].version != TM2C_HT_VERSION(address))
+	  {
+	    return WRITE_AFTER_READ;
+	  }
+
+	ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+	if (e != NULL && e->writer != SSHT_NO_WRITER && e->writer != node_id)
+	  {
+	    return WRITE_AFTER_READ;
+	  }
+      }
+
+    return NO_CONFLICT;
+  }
+#endif	/* INVISIBLE_READS */
+
   inline TM2C_CONFLICT_T
   tm2c_ht_insert(tm2c_ht_t tm2c_ht, nodeid_t node_id,
 		      tm_intern_addr_t address, RW rw)
   {
-#ifdef PGAS
-    uint32_t bu = (address) & NUM_OF_BUCKETS_2;
-#else  /* !PGAS */
-    uint32_t bu = tm2c_ht_get_hash(address) & NUM_OF_BUCKETS_2;
-#endif	/* PGAS */
+#if (ADDR_TO_DSL_SEL == 2)
+    dsl_dir_count(address);
+#endif
+#if defined(TM2C_RANGE_LOCKS)
+    if (rw == WRITE && range_log_entries > 0)
+      {
+	TM2C_CONFLICT_T conflict = tm2c_ht_check_range_readers(tm2c_ht, node_id, address);
+	if (conflict != NO_CONFLICT)
+	  {
+	    return conflict;
+	  }
+      }
+#endif	/* TM2C_RANGE_LOCKS */
+
+#if defined(INVISIBLE_READS)
+    if (rw == READ)
+      {
+	return tm2c_ht_insert_invisible(tm2c_ht, node_id, address);
+      }
+#endif	/* INVISIBLE_READS */
+
+    return TM2C_HT_INSERT(tm2c_ht, logs[node_id], node_id, address, rw);
+  }
+
+#if defined(TM2C_RANGE_LOCKS)
+  /*
+   * First, every word of the range is checked for a writer (as in
+   * bucket_insert_r), then the node is inserted as a reader of the range key
+   * of every region that the range overlaps.
+   */
+  TM2C_CONFLICT_T
+  tm2c_ht_insert_range(tm2c_ht_t tm2c_ht, nodeid_t node_id,
+		       tm_intern_addr_t address, size_t len)
+  {
+    tm_intern_addr_t a, end = address + len;
+    /* the writers lock aligned words */
+    for (a = address & ~((tm_intern_addr_t) TM2C_RANGE_WORD - 1); a < end; a += TM2C_RANGE_WORD)
+      {
+	ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, a);
+	if (e != NULL && e->writer != SSHT_NO_WRITER && e->writer != node_id)
+	  {
+#if defined(TX_PROFILE)
+	    range_conflict = a;	/* for the reply (tm2c_ht_holder) */
+#endif
+#if !defined(NOCM) && !defined(BACKOFF_RETRY) 	/* if any other CM (greedy, wholly, faircm) */
+	    if (!contention_manager_raw_waw(node_id, (uint16_t) e->writer, READ_AFTER_WRITE)) 
+	      {
+		return READ_AFTER_WRITE;
+	      }
+#else
+	    return READ_AFTER_WRITE;
+#endif	/* NOCM */
+	  }
+      }
+
+#if (ADDR_TO_DSL_SEL == 2)
+    dsl_dir_count(address);
+#endif
+    ssht_log_set_t* log = logs[node_id];
+    uint32_t nb_entries = log->nb_entries;
+    for (a = TM2C_RANGE_KEY(address); a < end; a += RANGE_LOCK_SIZE)
+      {
+	/* range keys have no writers, so this cannot conflict */
+	TM2C_HT_INSERT(tm2c_ht, log, node_id, a, READ);
+      }
+    range_node_entries[node_id] += log->nb_entries - nb_entries;
+    range_log_entries += log->nb_entries - nb_entries;
+#if defined(TX_PROFILE)
+    range_conflict = 0;
+#endif
+
+    return NO_CONFLICT;
+  }
+#endif	/* TM2C_RANGE_LOCKS */
+
+#if defined(PGAS_MVCC)
+  int32_t
+  tm2c_ht_writer(tm2c_ht_t tm2c_ht, tm_intern_addr_t address)
+  {
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+    if (e == NULL || e->writer == SSHT_NO_WRITER)
+      {
+	return -1;
+      }
+    return e->writer;
+  }
+#endif	/* PGAS_MVCC */
+
+#if defined(TX_PROFILE)
+  static inline nodeid_t
+  tm2c_ht_other_reader(ssht_rw_entry_t* e, nodeid_t node_id)
+  {
+    nodeid_t readers[MAX_READERS];
+    uint32_t i, num_readers = ssht_rw_entry_fetch_readers(e, readers);
+    for (i = 0; i < num_readers; i++)
+      {
+	if (readers[i] != node_id)
+	  {
+	    return readers[i];
+	  }
+      }
+    return TX_PROFILE_NO_NODE;
+  }
+
+  nodeid_t
+  tm2c_ht_holder(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t* address)
+  {
+#  if defined(TM2C_RANGE_LOCKS)
+    if (range_conflict != 0)
+      {
+	*address = range_conflict;
+	range_conflict = 0;
+      }
+#  endif	/* TM2C_RANGE_LOCKS */
+
+    nodeid_t holder = TX_PROFILE_NO_NODE;
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, *address);
+    if (e != NULL)
+      {
+	if (e->writer != SSHT_NO_WRITER && e->writer != node_id)
+	  {
+	    return e->writer;
+	  }
+	holder = tm2c_ht_other_reader(e, node_id);
+      }
+
+#  if defined(TM2C_RANGE_LOCKS)
+    if (holder == TX_PROFILE_NO_NODE && range_log_entries > 0)
+      {
+	e = TM2C_HT_LOOKUP(tm2c_ht, TM2C_RANGE_KEY(*address));
+	if (e != NULL)
+	  {
+	    holder = tm2c_ht_other_reader(e, node_id);
+	  }
+      }
+#  endif	/* TM2C_RANGE_LOCKS */
+    return holder;
+  }
+#endif	/* TX_PROFILE */
+
+#if defined(DSL_WAITQ)
+  uint32_t
+  tm2c_ht_holders_below(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t address)
+  {
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+    if (e == NULL)
+      {
+	return FALSE;		/* e.g., the conflict was on a range key */
+      }
 
-    return ssht_insert(tm2c_ht, bu, logs[node_id], node_id,  address, rw);
+    if (e->writer != SSHT_NO_WRITER && e->writer != node_id)
+      {
+	return (e->writer < node_id);
+      }
+
+    nodeid_t readers[MAX_READERS];
+    uint32_t i, num_readers = ssht_rw_entry_fetch_readers(e, readers);
+    for (i = 0; i < num_readers; i++)
+      {
+	if (readers[i] > node_id)
+	  {
+	    return FALSE;
+	  }
+      }
+    return (num_readers > 0);
   }
+#endif	/* DSL_WAITQ */
 
   inline void
   tm2c_ht_delete(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t address, RW rw)
   {
-    ssht_remove(logs[node_id], node_id, (addr_t*) address, rw);
+#if defined(INVISIBLE_READS)
+    if (rw == WRITE)
+      {
+	TM2C_HT_VERSION(address)++;
+      }
+#endif	/* INVISIBLE_READS */
+    /* O(1): the log entry is left behind, tm2c_ht_delete_node skips it */
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+    if (e != NULL)
+      {
+	TM2C_HT_REMOVE(tm2c_ht, node_id, e, rw);
+      }
   }
 
   inline void
@@ -110,13 +458,88 @@ extern "C" {
 	uint32_t j;
 	for (j = 0; j < log->nb_entries; j++) 
 	  {
-	    if (entries[j].address != NULL)
+	    if (entries[j].address != NULL && ssht_rw_entry_holds(entries[j].entry, node_id))
 	      {
-		ssht_remove_any(entries[j].address, node_id, entries[j].entry);
+#if defined(INVISIBLE_READS)
+		if (entries[j].entry->writer == node_id)
+		  {
+		    TM2C_HT_VERSION(*entries[j].address)++;
+		  }
+#endif	/* INVISIBLE_READS */
+		TM2C_HT_REMOVE_ANY(tm2c_ht, entries + j, node_id);
 	      }
 	  }
 	ssht_log_set_empty(log);
       }
+#if defined(TM2C_RANGE_LOCKS)
+    range_log_entries -= range_node_entries[node_id];
+    range_node_entries[node_id] = 0;
+#endif	/* TM2C_RANGE_LOCKS */
+#if defined(INVISIBLE_READS)
+    read_logs[node_id].nb_entries = 0;
+#endif	/* INVISIBLE_READS */
+  }
+
+  /* drops the stale entries of the log of the node (see tm2c_ht_delete), so
+     that the cost of the scan is amortized over the released locks */
+  static inline uint32_t
+  tm2c_ht_holds_any(nodeid_t node_id)
+  {
+    ssht_log_set_t* log = logs[node_id];
+    ssht_log_entry_t* entries = log->log_entries;
+    uint32_t j, kept = 0;
+    for (j = 0; j < log->nb_entries; j++)
+      {
+	if (entries[j].address != NULL && ssht_rw_entry_holds(entries[j].entry, node_id))
+	  {
+	    entries[kept++] = entries[j];
+	  }
+      }
+    log->nb_entries = kept;
+#if defined(INVISIBLE_READS)
+    kept += read_logs[node_id].nb_entries;
+#endif	/* INVISIBLE_READS */
+    return (kept > 0);
+  }
+
+  uint32_t
+  tm2c_ht_release(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t address)
+  {
+#if defined(INVISIBLE_READS)
+    tm2c_ht_read_log_t* rlog = read_logs + node_id;
+    uint32_t j, kept = 0;
+    for (j = 0; j < rlog->nb_entries; j++)
+      {
+	if (rlog->entries[j].address != address)
+	  {
+	    rlog->entries[kept++] = rlog->entries[j];
+	  }
+      }
+    rlog->nb_entries = kept;
+#endif	/* INVISIBLE_READS */
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+    if (e != NULL && e->writer != node_id)
+      {
+	TM2C_HT_REMOVE(tm2c_ht, node_id, e, READ);
+      }
+    return tm2c_ht_holds_any(node_id);
+  }
+
+  void
+  tm2c_ht_downgrade(tm2c_ht_t tm2c_ht, nodeid_t node_id, tm_intern_addr_t address)
+  {
+    ssht_rw_entry_t* e = TM2C_HT_LOOKUP(tm2c_ht, address);
+    if (e == NULL || e->writer != node_id)
+      {
+	return;
+      }
+#if defined(INVISIBLE_READS)
+    /* the write is dropped: the version of address stays the same */
+    tm2c_ht_read_log_add(node_id, address);
+    TM2C_HT_REMOVE(tm2c_ht, node_id, e, WRITE);
+#else
+    ssht_rw_entry_downgrade(e, node_id);
+#endif	/* INVISIBLE_READS */
   }
 
   inline void
@@ -124,6 +547,58 @@ extern "C" {
   {
   }
 
+#if defined(STATS_EXPORT)
+  void
+  tm2c_ht_stats_export(tm2c_ht_t tm2c_ht)
+  {
+#  if USE_HASHTABLE_SSHT
+    /* the buckets (including the expansions) and their occupied slots */
+    uint32_t b, i, buckets = 0, used = 0, written = 0;
+    for (b = 0; b < NUM_BUCKETS; b++)
+      {
+	bucket_t* bu;
+	for (bu = tm2c_ht + b; bu != NULL; bu = bu->next)
+	  {
+	    buckets++;
+	    for (i = 0; i < ADDR_PER_CL; i++)
+	      {
+		if (bu->tag[i] != 0)
+		  {
+		    used++;
+		    written += (bu->entry[i].writer != SSHT_NO_WRITER);
+		  }
+	      }
+	  }
+      }
+    tm2c_stats_u64("ht.buckets", buckets);
+    tm2c_stats_u64("ht.slots", buckets * ADDR_PER_CL);
+    tm2c_stats_u64("ht.used", used);
+    tm2c_stats_u64("ht.write_locked", written);
+#    if defined(SSHT_DBG_UTILIZATION)
+    tm2c_stats_u64("ht.insertions", ssht_dbg_usages);
+    tm2c_stats_u64("ht.expansions", ssht_dbg_bu_expansions);
+#      if SSHT_DBG_UTILIZATION_DTL == 1
+    char name[48];
+    for (b = 0; b < NUM_BUCKETS; b++)
+      {
+	snprintf(name, sizeof(name), "ht.bucket.%u.reads", b);
+	tm2c_stats_u64(name, ssht_dbg_bu_usages_r[b]);
+	snprintf(name, sizeof(name), "ht.bucket.%u.writes", b);
+	tm2c_stats_u64(name, ssht_dbg_bu_usages_w[b]);
+      }
+#      endif
+#    endif	/* SSHT_DBG_UTILIZATION */
+#  else  /* USE_HASHTABLE_OAHT */
+    tm2c_stats_u64("ht.groups", tm2c_ht->cur.num_groups);
+    tm2c_stats_u64("ht.slots", tm2c_ht->cur.num_groups * OAHT_GROUP_SLOTS);
+    tm2c_stats_u64("ht.used", tm2c_ht->cur.live);
+    tm2c_stats_u64("ht.tombstones", tm2c_ht->cur.tombstones);
+    tm2c_stats_u64("ht.resizes", tm2c_ht->resizes);
+    tm2c_stats_u64("ht.records", tm2c_ht->num_chunks * OAHT_REC_CHUNK);
+#  endif	/* USE_HASHTABLE_SSHT */
+  }
+#endif	/* STATS_EXPORT */
+
 #endif
 
 #ifdef    __cplusplus
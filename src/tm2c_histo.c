@@ -0,0 +1,203 @@
+/*
+ *   File: tm2c_histo.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: log-bucketed latency histograms of the transactions, the
+ *                RPCs, and the commit phases (TX_HISTO)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "tm2c_histo.h"
+
+#if defined(TX_HISTO)
+
+#include "tm2c_rpc.h"
+
+tm2c_histo_t tm2c_histos[TM2C_HISTO_NUM];
+
+static const char* histos_names[TM2C_HISTO_NUM] =
+  {
+    "tx", "load", "store", "commit", "commit_acq", "commit_persist", "commit_rls"
+  };
+
+#define TM2C_HISTO_NUM_PERC 4
+static const double percentiles[TM2C_HISTO_NUM_PERC] = { 0.5, 0.9, 0.99, 0.999 };
+static const char* percentiles_names[TM2C_HISTO_NUM_PERC] = { "p50", "p90", "p99", "p999" };
+
+typedef struct tm2c_histo_summary
+{
+  uint64_t count;
+  double mean;			/* the rest in ns */
+  double perc[TM2C_HISTO_NUM_PERC];
+  double max;
+} tm2c_histo_summary_t;
+
+/* the middle of the values of the bucket */
+static ticks
+tm2c_histo_value(uint32_t bucket)
+{
+  if (bucket < TM2C_HISTO_SUB)
+    {
+      return bucket;
+    }
+  uint32_t shift = (bucket >> TM2C_HISTO_SUB_BITS) - 1;
+  ticks low = ((ticks) (TM2C_HISTO_SUB + (bucket & (TM2C_HISTO_SUB - 1)))) << shift;
+  return low + (((ticks) 1 << shift) >> 1);
+}
+
+static inline double
+tm2c_histo_ns(ticks value)
+{
+  return value / REF_SPEED_GHZ;
+}
+
+/* returns FALSE if the histogram is empty */
+static uint32_t
+tm2c_histo_summarize(tm2c_histo_t histo, tm2c_histo_summary_t* s)
+{
+  uint32_t b, p;
+  double sum = 0;
+  memset(s, 0, sizeof(tm2c_histo_summary_t));
+  for (b = 0; b < TM2C_HISTO_BUCKETS; b++)
+    {
+      if (histo[b] > 0)
+	{
+	  s->count += histo[b];
+	  sum += (double) histo[b] * tm2c_histo_value(b);
+	  s->max = tm2c_histo_ns(tm2c_histo_value(b));
+	}
+    }
+  if (s->count == 0)
+    {
+      return FALSE;
+    }
+  s->mean = tm2c_histo_ns(sum / s->count);
+
+  uint64_t seen = 0;
+  for (b = 0, p = 0; b < TM2C_HISTO_BUCKETS && p < TM2C_HISTO_NUM_PERC; b++)
+    {
+      seen += histo[b];
+      /* the bucket of the rank ceil(percentile * count) */
+      while (p < TM2C_HISTO_NUM_PERC && seen >= percentiles[p] * s->count)
+	{
+	  s->perc[p++] = tm2c_histo_ns(tm2c_histo_value(b));
+	}
+    }
+  return TRUE;
+}
+
+void
+tm2c_histo_send()
+{
+  tm2c_histo_msg_t* msg = (tm2c_histo_msg_t*) malloc(sizeof(ssmp_msg_t));
+  assert(msg != NULL && sizeof(tm2c_histo_msg_t) < sizeof(ssmp_msg_t));
+
+  msg->type = TM2C_RPC_HISTO;
+  msg->nodeId = NODE_ID();
+
+  uint32_t h, b;
+  for (h = 0; h < TM2C_HISTO_NUM; h++)
+    {
+      msg->histo = h;
+      msg->num = 0;
+      for (b = 0; b < TM2C_HISTO_BUCKETS; b++)
+	{
+	  if (tm2c_histos[h][b] == 0)
+	    {
+	      continue;
+	    }
+	  msg->bucket[msg->num] = b;
+	  msg->count[msg->num] = tm2c_histos[h][b];
+	  if (++msg->num == TM2C_HISTO_MSG_BUCKETS)
+	    {
+	      sys_sendcmd(msg, sizeof(tm2c_histo_msg_t), min_dsl_id());
+	      msg->num = 0;
+	    }
+	}
+      if (msg->num > 0)
+	{
+	  sys_sendcmd(msg, sizeof(tm2c_histo_msg_t), min_dsl_id());
+	}
+    }
+
+  free(msg);
+}
+
+void
+tm2c_histo_merge(tm2c_histo_msg_t* msg)
+{
+  uint32_t i;
+  for (i = 0; i < msg->num; i++)
+    {
+      tm2c_histos[msg->histo][msg->bucket[i]] += msg->count[i];
+    }
+}
+
+void
+tm2c_histo_print()
+{
+  uint32_t h, p;
+  tm2c_histo_summary_t s;
+
+  printf(":: LATENCY (ns) ----------------------------------------------\n");
+  for (h = 0; h < TM2C_HISTO_NUM; h++)
+    {
+      if (!tm2c_histo_summarize(tm2c_histos[h], &s))
+	{
+	  continue;
+	}
+      printf("HL| %-14s\t: %-9lu avg %-9.0f", histos_names[h], (LU) s.count, s.mean);
+      for (p = 0; p < TM2C_HISTO_NUM_PERC; p++)
+	{
+	  printf(" %s %-9.0f", percentiles_names[p], s.perc[p]);
+	}
+      printf(" max %.0f\n", s.max);
+    }
+}
+
+#if defined(STATS_EXPORT)
+void
+tm2c_histo_stats_export()
+{
+  uint32_t h, p;
+  tm2c_histo_summary_t s;
+  char name[64];
+
+  for (h = 0; h < TM2C_HISTO_NUM; h++)
+    {
+      if (!tm2c_histo_summarize(tm2c_histos[h], &s))
+	{
+	  continue;
+	}
+      snprintf(name, sizeof(name), "latency.%s.count", histos_names[h]);
+      tm2c_stats_u64(name, s.count);
+      snprintf(name, sizeof(name), "latency.%s.avg_ns", histos_names[h]);
+      tm2c_stats_f64(name, s.mean);
+      for (p = 0; p < TM2C_HISTO_NUM_PERC; p++)
+	{
+	  snprintf(name, sizeof(name), "latency.%s.%s_ns", histos_names[h], percentiles_names[p]);
+	  tm2c_stats_f64(name, s.perc[p]);
+	}
+      snprintf(name, sizeof(name), "latency.%s.max_ns", histos_names[h]);
+      tm2c_stats_f64(name, s.max);
+    }
+}
+#endif	/* STATS_EXPORT */
+
+#endif	/* TX_HISTO */
@@ -0,0 +1,100 @@
+/*
+ *   File: tm2c_irrevoc.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: the system-wide token of the irrevocable transactions
+ *                (IRREVOCABLE)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "tm2c_irrevoc.h"
+
+#if defined(IRREVOCABLE)
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#include "tm2c.h"
+
+volatile nodeid_t* tm2c_irrevoc_owner;
+
+#define TM2C_IRREVOC_KEY   "/tm2c_irrevoc"
+
+static uint32_t grants = 0;	/* on the first DSL core */
+
+void
+tm2c_irrevoc_init()
+{
+  int fd = shm_open(TM2C_IRREVOC_KEY, O_CREAT | O_RDWR, S_IRWXU | S_IRWXG);
+  if (fd < 0)
+    {
+      perror("In shm_open");
+      exit(1);
+    }
+
+  if (ftruncate(fd, CACHE_LINE_SIZE))
+    {
+      printf("ftruncate");
+    }
+
+  tm2c_irrevoc_owner = (volatile nodeid_t*) mmap(NULL, CACHE_LINE_SIZE, PROT_READ | PROT_WRITE,
+						 MAP_SHARED, fd, 0);
+  assert(tm2c_irrevoc_owner != MAP_FAILED);
+
+  /* also if it already exists: might be left over from another run */
+  if (NODE_ID() == min_dsl_id())
+    {
+      *tm2c_irrevoc_owner = TM2C_IRREVOC_NONE;
+    }
+}
+
+void
+tm2c_irrevoc_term()
+{
+  if (grants > 0)
+    {
+      printf("[%02d] irrevocable transactions: %u\n", NODE_ID(), grants);
+    }
+  shm_unlink(TM2C_IRREVOC_KEY);
+}
+
+TM2C_CONFLICT_T
+tm2c_irrevoc_grant(nodeid_t sender)
+{
+  if (*tm2c_irrevoc_owner == sender ||
+      __sync_bool_compare_and_swap(tm2c_irrevoc_owner, TM2C_IRREVOC_NONE, sender))
+    {
+      grants++;
+      return NO_CONFLICT;
+    }
+  return WRITE_AFTER_WRITE;
+}
+
+void
+tm2c_irrevoc_release(nodeid_t sender)
+{
+  if (*tm2c_irrevoc_owner == sender)
+    {
+      __sync_synchronize();
+      *tm2c_irrevoc_owner = TM2C_IRREVOC_NONE;
+    }
+}
+
+#endif	/* IRREVOCABLE */
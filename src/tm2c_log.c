@@ -31,9 +31,19 @@
  */
 
 #include "tm2c_log.h"
+#if defined(PGAS_MVCC)
+#include "pgas_mvcc.h"
+#endif  /* PGAS_MVCC */
 #if defined(PLATFORM_TILERA)
 #include <tmc/mem.h>
 #endif  /* PLATFORM_TILERA */
+#if defined(WRITE_BACK_RUNS) && (WRITE_BACK_RUNS == 2) && defined(__SSE2__)
+#include <emmintrin.h>
+#define WRITE_BACK_STREAM
+#endif  /* WRITE_BACK_RUNS */
+
+#define WRITE_BACK_RUNS_MIN 16	/* smaller write sets are persisted per entry */
+#define WRITE_BACK_RUN      256	/* bytes staged per write back */
 
 tm2c_write_set_t* 
 write_set_new() 
@@ -55,6 +65,18 @@ write_set_new()
 
   write_set->nb_entries = 0;
   write_set->size = WRITE_SET_SIZE;
+  write_set->nb_words = 0;
+  write_set->bloom = 0;
+  write_set->index = NULL;
+  write_set->index_size = 0;
+  write_set->epoch = 1;
+  write_set->blocks = NULL;
+  write_set->blocks_used = 0;
+  write_set->blocks_size = 0;
+#if defined(WRITE_BACK_RUNS)
+  write_set->ordered = 1;
+  write_set->end = 0;
+#endif	/* WRITE_BACK_RUNS */
 
   return write_set;
 }
@@ -62,6 +84,8 @@ write_set_new()
 void 
 write_set_free(tm2c_write_set_t* write_set) 
 {
+    free(write_set->blocks);
+    free(write_set->index);
     free(write_set->write_entries);
     free(write_set);
 }
@@ -70,6 +94,22 @@ inline tm2c_write_set_t*
 write_set_empty(tm2c_write_set_t* write_set) 
 {
     write_set->nb_entries = 0;
+    write_set->nb_words = 0;
+    write_set->blocks_used = 0;
+#if defined(WRITE_BACK_RUNS)
+    write_set->ordered = 1;
+    write_set->end = 0;
+#endif	/* WRITE_BACK_RUNS */
+    write_set->bloom = 0;
+    /* invalidates all the slots of the index */
+    if (++write_set->epoch == 0)
+      {
+	if (write_set->index != NULL)
+	  {
+	    memset(write_set->index, 0, write_set->index_size * sizeof(write_set_slot_t));
+	  }
+	write_set->epoch = 1;
+      }
     return write_set;
 }
 
@@ -95,32 +135,219 @@ write_set_entry(tm2c_write_set_t*write_set)
 }
 
 inline void 
-write_entry_set_value(write_entry_t* we, int32_t value) 
+write_entry_set_value(write_entry_t* we, int64_t value) 
+{
+  switch (we->type)
+    {
+    case TYPE_INT8:
+      we->i8 = (int8_t) value;
+      break;
+    case TYPE_INT16:
+      we->i16 = (int16_t) value;
+      break;
+    case TYPE_INT64:
+      we->i64 = value;
+      break;
+    default:
+      we->i = (int32_t) value;
+      break;
+    }
+}
+
+/* points the slot of address to entry e */
+static inline void
+write_set_index_put(tm2c_write_set_t* write_set, tm_intern_addr_t address, uint32_t e)
+{
+  write_set_slot_t* index = write_set->index;
+  uint32_t mask = write_set->index_size - 1;
+  uint32_t i = WRITE_SET_HASH(address) & mask;
+  while (index[i].epoch == write_set->epoch && index[i].address != address)
+    {
+      i = (i + 1) & mask;
+    }
+  index[i].address = address;
+  index[i].epoch = write_set->epoch;
+  index[i].entry = e;
+}
+
+static inline void
+write_set_index_put_entry(tm2c_write_set_t* write_set, uint32_t e)
 {
-  we->i = value;
+  write_entry_t* we = write_set->write_entries + e;
+  uint32_t w, words = WRITE_ENTRY_WORDS(we);
+  for (w = 0; w < words; w++)
+    {
+      write_set_index_put(write_set, we->address + w * WRITE_SET_WORD, e);
+    }
+}
+
+/* called after appending an entry */
+static inline void
+write_set_index_add(tm2c_write_set_t* write_set)
+{
+  uint32_t n = write_set->nb_entries;
+  if (n < WRITE_SET_INDEX_MIN)
+    {
+      return;
+    }
+
+  uint32_t reindex = (n == WRITE_SET_INDEX_MIN);
+  uint32_t words = write_set->nb_words;
+  if (write_set->index_size < 2 * words)	/* keep the load under 1/2 */
+    {
+      uint32_t size = (write_set->index_size == 0) ? WRITE_SET_INDEX_SIZE : write_set->index_size;
+      while (size < 2 * words)
+	{
+	  size *= 2;
+	}
+
+      free(write_set->index);
+      write_set->index = (write_set_slot_t*) calloc(size, sizeof(write_set_slot_t));
+      assert(write_set->index != NULL);
+      write_set->index_size = size;
+      reindex = 1;
+    }
+
+  if (reindex)
+    {
+      uint32_t e;
+      for (e = 0; e < n; e++)
+	{
+	  write_set_index_put_entry(write_set, e);
+	}
+    }
+  else
+    {
+      write_set_index_put_entry(write_set, n - 1);
+    }
+}
+
+/* we is the last entry */
+static inline void
+write_set_add(tm2c_write_set_t* write_set, write_entry_t* we)
+{
+  uint32_t w, words = WRITE_ENTRY_WORDS(we);
+  for (w = 0; w < words; w++)
+    {
+      write_set->bloom |= WRITE_SET_BLOOM(WRITE_SET_HASH(we->address + w * WRITE_SET_WORD));
+    }
+  write_set->nb_words += words;
+  write_set_index_add(write_set);
+
+#if defined(WRITE_BACK_RUNS)
+  if (we->address < write_set->end)
+    {
+      write_set->ordered = 0;
+    }
+  write_set->end = we->address + WRITE_ENTRY_SIZE(we);
+#endif	/* WRITE_BACK_RUNS */
+}
+
+void
+write_set_truncate(tm2c_write_set_t* write_set, uint32_t nb_entries, uint32_t blocks_used)
+{
+  uint32_t e;
+  if (nb_entries >= write_set->nb_entries)
+    {
+      return;
+    }
+
+  /* the bloom filter and the index are rebuilt from the kept entries */
+  write_set_empty(write_set);
+  write_set->blocks_used = blocks_used;
+  for (e = 0; e < nb_entries; e++)
+    {
+      write_set->nb_entries = e + 1;
+      write_set_add(write_set, write_set->write_entries + e);
+    }
+}
+
+uint32_t
+write_set_remove(tm2c_write_set_t* write_set, tm_intern_addr_t address)
+{
+  uint32_t e, kept = 0, nb_entries = write_set->nb_entries, blocks_used = write_set->blocks_used;
+  if (write_set_contains(write_set, address) == NULL)
+    {
+      return 0;
+    }
+
+  /* as in write_set_truncate, the bloom filter and the index are rebuilt */
+  write_set_empty(write_set);
+  write_set->blocks_used = blocks_used;
+  for (e = 0; e < nb_entries; e++)
+    {
+      write_entry_t* we = write_set->write_entries + e;
+      if (we->type != TYPE_BLOCK && we->address == address)
+	{
+	  continue;
+	}
+      write_set->write_entries[kept] = *we;
+      write_set->nb_entries = ++kept;
+      write_set_add(write_set, write_set->write_entries + kept - 1);
+    }
+  return nb_entries - kept;
 }
 
 inline void 
-write_set_insert(tm2c_write_set_t* write_set, DATATYPE datatype, int32_t value, tm_intern_addr_t address) 
+write_set_insert(tm2c_write_set_t* write_set, DATATYPE datatype, int64_t value, tm_intern_addr_t address) 
 {
     write_entry_t *we = write_set_entry(write_set);
 
     we->address = address;
     we->type = datatype;
+    we->len = 0;
+    /* the rest of the word is merged from the memory, so that a wider load
+       of address (write_entry_value) sees the value */
+    if (datatype == TYPE_INT8 || datatype == TYPE_INT16)
+      {
+	memcpy(&we->i64, (void*) to_addr(address), WRITE_SET_WORD - (address % WRITE_SET_WORD));
+      }
     write_entry_set_value(we, value);
+    write_set_add(write_set, we);
 }
 
-inline void 
-write_set_update(tm2c_write_set_t* write_set, DATATYPE datatype, int32_t value, tm_intern_addr_t address) 
+write_entry_t*
+write_set_insert_block(tm2c_write_set_t* write_set, const void* src, uint32_t len, tm_intern_addr_t address)
 {
-  uint32_t i;
-  for (i = 0; i < write_set->nb_entries; i++) 
+  uint32_t offset = write_set->blocks_used;
+  uint32_t used = offset + ((len + 7) & ~7);	/* keep the blocks 8-byte aligned */
+  if (used > write_set->blocks_size)
     {
-      if (write_set->write_entries[i].address == address) 
+      uint32_t size = (write_set->blocks_size == 0) ? WRITE_SET_BLOCKS_SIZE : write_set->blocks_size;
+      while (size < used)
 	{
-	  write_entry_set_value(&write_set->write_entries[i], value);
-	  return;
+	  size *= 2;
 	}
+
+      uint8_t* temp;
+      if ((temp = (uint8_t*) realloc(write_set->blocks, size)) == NULL)
+	{
+	  PRINT("Could not resize the write set blocks");
+	  EXIT(-1);
+	}
+      write_set->blocks = temp;
+      write_set->blocks_size = size;
+    }
+  memcpy(write_set->blocks + offset, src, len);
+  write_set->blocks_used = used;
+
+  write_entry_t *we = write_set_entry(write_set);
+  we->address = address;
+  we->type = TYPE_BLOCK;
+  we->len = len;
+  we->i64 = offset;
+  write_set_add(write_set, we);
+  return we;
+}
+
+inline void 
+write_set_update(tm2c_write_set_t* write_set, DATATYPE datatype, int64_t value, tm_intern_addr_t address) 
+{
+  write_entry_t* we = write_set_contains(write_set, address);
+  if (we != NULL && we->type == datatype && we->address == address)
+    {
+      write_entry_set_value(we, value);
+      return;
     }
 
   write_set_insert(write_set, datatype, value, address);
@@ -137,24 +364,34 @@ write_entry_persist(write_entry_t* we)
 {
   tm_addr_t shmem_address = to_addr(we->address);
 
-#if defined(PLATFORM_NIAGARA)
-  if (we->type == TYPE_INT)
+  switch (we->type)
     {
+    case TYPE_INT8:
+      *(int8_t*)(shmem_address) = we->i8;
+      break;
+    case TYPE_INT16:
+      *(int16_t*)(shmem_address) = we->i16;
+      break;
+    case TYPE_INT64:
+      *(int64_t*)(shmem_address) = we->i64;
+      break;
+    default:
       *(int32_t*)(shmem_address) = we->i;
+      break;
     }
-  else
-    {
-      *(int64_t*)(shmem_address) = we->i;
-    }
-#else
-  *(int32_t*)(shmem_address) = we->i;
-#endif	/* PLATFORM_NIAGARA */
 }
 
 void
 write_entry_print(write_entry_t* we) 
 {
-  PRINTSME("[%"PRIxIA" :  %d]", (we->address), we->i);
+  if (we->type == TYPE_BLOCK)
+    {
+      PRINTSME("[%"PRIxIA" :  block of %u]", (we->address), we->len);
+    }
+  else
+    {
+      PRINTSME("[%"PRIxIA" :  %lld]", (we->address), (long long int) we->i64);
+    }
 }
 
 void write_set_print(tm2c_write_set_t* write_set) 
@@ -168,15 +405,116 @@ void write_set_print(tm2c_write_set_t* write_set)
   FLUSH;
 }
 
+#if defined(WRITE_BACK_RUNS)
+static inline void
+write_set_write_back(tm_intern_addr_t address, const uint8_t* from, uint32_t len)
+{
+  uint8_t* to = (uint8_t*) to_addr(address);
+#if defined(WRITE_BACK_STREAM)
+  uint32_t head = (CACHE_LINE_SIZE - ((uintptr_t) to & (CACHE_LINE_SIZE - 1))) & (CACHE_LINE_SIZE - 1);
+  if (len >= head + CACHE_LINE_SIZE)
+    {
+      memcpy(to, from, head);
+      to += head;
+      from += head;
+      len -= head;
+      while (len >= CACHE_LINE_SIZE)
+	{
+	  uint32_t k;
+	  for (k = 0; k < CACHE_LINE_SIZE / sizeof(__m128i); k++)
+	    {
+	      _mm_stream_si128((__m128i*) to + k, _mm_loadu_si128((const __m128i*) from + k));
+	    }
+	  to += CACHE_LINE_SIZE;
+	  from += CACHE_LINE_SIZE;
+	  len -= CACHE_LINE_SIZE;
+	}
+    }
+#endif	/* WRITE_BACK_STREAM */
+  memcpy(to, from, len);
+}
+
+/* the entries are in increasing, non-overlapping address order */
+static void
+write_set_persist_runs(tm2c_write_set_t* write_set)
+{
+  uint8_t run[WRITE_BACK_RUN] ALIGNED(16);
+  tm_intern_addr_t run_start = 0;
+  uint32_t i, run_len = 0;
+  for (i = 0; i < write_set->nb_entries; i++)
+    {
+      write_entry_t* we = write_set->write_entries + i;
+      const uint8_t* from = (const uint8_t*) write_entry_value(write_set, we, we->address);
+      uint32_t size = WRITE_ENTRY_SIZE(we);
+
+      if (run_len > 0 && (we->address != run_start + run_len || run_len + size > WRITE_BACK_RUN))
+	{
+	  write_set_write_back(run_start, run, run_len);
+	  run_len = 0;
+	}
+
+      if (size > WRITE_BACK_RUN)
+	{
+	  write_set_write_back(we->address, from, size);
+	}
+      else
+	{
+	  if (run_len == 0)
+	    {
+	      run_start = we->address;
+	    }
+	  switch (we->type)	/* constant sizes for the common types */
+	    {
+	    case TYPE_INT:
+	      memcpy(run + run_len, &we->i, sizeof(int32_t));
+	      break;
+	    case TYPE_INT64:
+	      memcpy(run + run_len, &we->i64, sizeof(int64_t));
+	      break;
+	    default:
+	      memcpy(run + run_len, from, size);
+	      break;
+	    }
+	  run_len += size;
+	}
+    }
+
+  if (run_len > 0)
+    {
+      write_set_write_back(run_start, run, run_len);
+    }
+}
+#endif	/* WRITE_BACK_RUNS */
+
 inline void 
 write_set_persist(tm2c_write_set_t* write_set) 
 {
-  uint32_t i;
-  for (i = 0; i < write_set->nb_entries; i++) 
+#if defined(WRITE_BACK_RUNS)
+  if (write_set->nb_entries >= WRITE_BACK_RUNS_MIN && write_set->ordered)
     {
-      write_entry_persist(write_set->write_entries + i);
+      write_set_persist_runs(write_set);
+    }
+  else
+#endif	/* WRITE_BACK_RUNS */
+    {
+      uint32_t i;
+      for (i = 0; i < write_set->nb_entries; i++) 
+	{
+	  write_entry_t* we = write_set->write_entries + i;
+	  if (we->type == TYPE_BLOCK)
+	    {
+	      memcpy(to_addr(we->address), write_set->blocks + we->i64, we->len);
+	    }
+	  else
+	    {
+	      write_entry_persist(we);
+	    }
+	}
     }
   
+#if defined(WRITE_BACK_STREAM)
+  _mm_sfence();
+#endif  /* WRITE_BACK_STREAM */
 #if defined(PLATFORM_TILERA)
   tmc_mem_fence();
 #elif defined(PLATFORM_NIAGARA)
@@ -184,17 +522,40 @@ write_set_persist(tm2c_write_set_t* write_set)
 #endif  /* PLATFORM_* */
 }
 
+/* returns the last entry of the address (see write_entry_value) */
 inline write_entry_t* 
 write_set_contains(tm2c_write_set_t* write_set, tm_intern_addr_t address) 
 {
-  uint32_t i;
-  for (i = 0; i < write_set->nb_entries; i++)
+  uint32_t hash = WRITE_SET_HASH(address);
+  if (!(write_set->bloom & WRITE_SET_BLOOM(hash)))
+    {
+      return NULL;
+    }
+
+  write_entry_t* wes = write_set->write_entries;
+  if (write_set->nb_entries < WRITE_SET_INDEX_MIN)
     {
-      write_entry_t* wes = write_set->write_entries;
-      if (wes[i].address == address) 
+      uint32_t i;
+      for (i = write_set->nb_entries; i-- > 0;)
 	{
-	  return wes + i;
+	  if (WRITE_ENTRY_COVERS(wes + i, address))
+	    {
+	      return wes + i;
+	    }
 	}
+      return NULL;
+    }
+
+  write_set_slot_t* index = write_set->index;
+  uint32_t mask = write_set->index_size - 1;
+  uint32_t i = hash & mask;
+  while (index[i].epoch == write_set->epoch)
+    {
+      if (index[i].address == address)
+	{
+	  return wes + index[i].entry;
+	}
+      i = (i + 1) & mask;
     }
 
   return NULL;
@@ -292,6 +653,20 @@ write_set_pgas_update(tm2c_write_set_pgas_t* write_set_pgas, int64_t value, tm_i
   write_set_pgas_insert(write_set_pgas, value, address);
 }
 
+void
+write_set_pgas_remove(tm2c_write_set_pgas_t* write_set_pgas, tm_intern_addr_t address)
+{
+  uint32_t i, kept = 0;
+  for (i = 0; i < write_set_pgas->nb_entries; i++)
+    {
+      if (write_set_pgas->write_entries[i].address != address)
+	{
+	  write_set_pgas->write_entries[kept++] = write_set_pgas->write_entries[i];
+	}
+    }
+  write_set_pgas->nb_entries = kept;
+}
+
 inline void 
 write_entry_pgas_persist(write_entry_pgas_t* we) 
 {
@@ -322,7 +697,12 @@ write_set_pgas_persist(tm2c_write_set_pgas_t* write_set_pgas)
   uint32_t i;
   for (i = 0; i < write_set_pgas->nb_entries; i++) 
     {
+#if defined(PGAS_MVCC)
+      write_entry_pgas_t* we = write_set_pgas->write_entries + i;
+      pgas_mvcc_write(we->address, we->value, write_set_pgas->owner);
+#else
       write_entry_pgas_persist(write_set_pgas->write_entries + i);
+#endif	/* PGAS_MVCC */
     }
   return i;
 }
@@ -280,3 +280,54 @@ mem_info_on_abort(mem_info_t *stm_mem_info)
       stm_mem_info->freed_shmem = NULL;
     }
 }
+
+    /*
+     * Called upon the rollback of a nested block: as mem_info_on_abort, for
+     * the blocks that were added after the heads in saved.
+     */
+void
+mem_info_on_rollback(mem_info_t *stm_mem_info, mem_info_t *saved)
+{
+  mem_block_t *mb, *next;
+
+  /* Dispose of memory allocated during the block */
+  mb = stm_mem_info->allocated;
+  while (mb != saved->allocated)
+    {
+      next = mb->next;
+      free(mb->addr);
+      free(mb);
+      mb = next;
+    }
+  stm_mem_info->allocated = saved->allocated;
+
+  /* Dispose of shared memory allocated during the block */
+  mb = stm_mem_info->allocated_shmem;
+  while (mb != saved->allocated_shmem)
+    {
+      next = mb->next;
+      sys_shfree((void*) mb->addr);
+      free(mb);
+      mb = next;
+    }
+  stm_mem_info->allocated_shmem = saved->allocated_shmem;
+
+  /* Keep memory freed during the block */
+  mb = stm_mem_info->freed;
+  while (mb != saved->freed)
+    {
+      next = mb->next;
+      free(mb);
+      mb = next;
+    }
+  stm_mem_info->freed = saved->freed;
+
+  mb = stm_mem_info->freed_shmem;
+  while (mb != saved->freed_shmem)
+    {
+      next = mb->next;
+      free(mb);
+      mb = next;
+    }
+  stm_mem_info->freed_shmem = saved->freed_shmem;
+}
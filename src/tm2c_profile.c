@@ -0,0 +1,357 @@
+/*
+ *   File: tm2c_profile.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: attribution of the aborts to transaction sites,
+ *                conflicting addresses, and winners (TX_PROFILE)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "tm2c_profile.h"
+
+#if defined(TX_PROFILE)
+
+#include "tm2c_rpc.h"
+#include "hash.h"
+
+tm_intern_addr_t tm2c_profile_addr = 0;
+nodeid_t tm2c_profile_winner = TX_PROFILE_NO_NODE;
+
+/* app: TX_PROFILE_SIZE records, dsl: TX_PROFILE_DSL_SIZE */
+static tm2c_profile_rec_t* recs = NULL;
+static uint32_t recs_size = 0;
+static uint32_t recs_dropped = 0; /* aborts that found the table full */
+
+static inline uint32_t
+tm2c_profile_hash(const char* file, uint32_t line, uint32_t conflict,
+		  tm_intern_addr_t address, nodeid_t winner)
+{
+  return hash_tw((uint32_t) ((uintptr_t) file ^ (line << 8) ^ (conflict << 4) ^ (address >> 2) ^ (winner << 16)));
+}
+
+/* adds count to the record of the key. Returns FALSE if the table is full */
+static uint32_t
+tm2c_profile_add(const char* file, uint32_t line, uint32_t conflict,
+		 tm_intern_addr_t address, nodeid_t winner, uint32_t count)
+{
+  uint32_t mask = recs_size - 1, n;
+  uint32_t i = tm2c_profile_hash(file, line, conflict, address, winner) & mask;
+  for (n = 0; n < recs_size; n++, i = (i + 1) & mask)
+    {
+      tm2c_profile_rec_t* r = recs + i;
+      if (r->count == 0)
+	{
+	  r->file = file;
+	  r->line = line;
+	  r->conflict = conflict;
+	  r->address = address;
+	  r->winner = winner;
+	  r->count = count;
+	  return TRUE;
+	}
+      if (r->file == file && r->line == line && r->conflict == conflict
+	  && r->address == address && r->winner == winner)
+	{
+	  r->count += count;
+	  return TRUE;
+	}
+    }
+  return FALSE;
+}
+
+static void
+tm2c_profile_alloc(uint32_t size)
+{
+  recs = (tm2c_profile_rec_t*) calloc(size, sizeof(tm2c_profile_rec_t));
+  assert(recs != NULL);
+  recs_size = size;
+}
+
+void
+tm2c_profile_abort(const char* file, uint32_t line, TM2C_CONFLICT_T reason)
+{
+  if (recs == NULL)
+    {
+      tm2c_profile_alloc(TX_PROFILE_SIZE);
+    }
+
+  if (!tm2c_profile_add(file, line, reason, tm2c_profile_addr, tm2c_profile_winner, 1))
+    {
+      recs_dropped++;
+    }
+  tm2c_profile_forget();
+}
+
+void
+tm2c_profile_send()
+{
+  tm2c_profile_msg_t* msg = (tm2c_profile_msg_t*) malloc(sizeof(TM2C_RPC_STATS_T));
+  assert(msg != NULL && sizeof(tm2c_profile_msg_t) <= sizeof(TM2C_RPC_STATS_T));
+
+  msg->type = TM2C_RPC_PROFILE;
+  msg->nodeId = NODE_ID();
+
+  uint32_t i;
+  for (i = 0; i < recs_size; i++)
+    {
+      tm2c_profile_rec_t* r = recs + i;
+      if (r->count == 0)
+	{
+	  continue;
+	}
+      msg->file = r->file;
+      msg->line = r->line;
+      msg->conflict = r->conflict;
+      msg->address = r->address;
+      msg->winner = r->winner;
+      msg->count = r->count;
+      sys_sendcmd(msg, sizeof(tm2c_profile_msg_t), min_dsl_id());
+    }
+
+  if (recs_dropped > 0)
+    {
+      msg->file = NULL;		/* the dropped aborts */
+      msg->count = recs_dropped;
+      sys_sendcmd(msg, sizeof(tm2c_profile_msg_t), min_dsl_id());
+    }
+
+  free(msg);
+  free(recs);
+  recs = NULL;
+  recs_size = 0;
+  recs_dropped = 0;
+}
+
+void
+tm2c_profile_merge(tm2c_profile_msg_t* msg)
+{
+  if (recs == NULL)
+    {
+      tm2c_profile_alloc(TX_PROFILE_DSL_SIZE);
+    }
+
+  if (msg->file == NULL)
+    {
+      recs_dropped += msg->count;
+      return;
+    }
+
+  nodeid_t winner = (msg->winner == (uint16_t) TX_PROFILE_NO_NODE) ? TX_PROFILE_NO_NODE : msg->winner;
+  if (!tm2c_profile_add(msg->file, msg->line, msg->conflict, msg->address, winner, msg->count))
+    {
+      recs_dropped += msg->count;
+    }
+}
+
+/*
+ * Printing: the records are sorted by address (or site), the ones of the
+ * same address (site) are summed up to a group, and the groups are sorted
+ * by their aborts.
+ */
+
+typedef struct tm2c_profile_group
+{
+  tm2c_profile_rec_t* first;	/* of the sorted records */
+  uint32_t num_recs;
+  uint32_t aborts;
+  uint32_t per_conflict[4];	/* NO_CONFLICT (other reasons), RAW, WAR, WAW */
+} tm2c_profile_group_t;
+
+static int
+tm2c_profile_cmp_address(const void* a, const void* b)
+{
+  const tm2c_profile_rec_t* ra = (const tm2c_profile_rec_t*) a;
+  const tm2c_profile_rec_t* rb = (const tm2c_profile_rec_t*) b;
+  return (ra->address > rb->address) - (ra->address < rb->address);
+}
+
+static int
+tm2c_profile_cmp_site(const void* a, const void* b)
+{
+  const tm2c_profile_rec_t* ra = (const tm2c_profile_rec_t*) a;
+  const tm2c_profile_rec_t* rb = (const tm2c_profile_rec_t*) b;
+  if (ra->file != rb->file)
+    {
+      return ((uintptr_t) ra->file > (uintptr_t) rb->file) ? 1 : -1;
+    }
+  return (ra->line > rb->line) - (ra->line < rb->line);
+}
+
+static int
+tm2c_profile_cmp_aborts(const void* a, const void* b)
+{
+  const tm2c_profile_group_t* ga = (const tm2c_profile_group_t*) a;
+  const tm2c_profile_group_t* gb = (const tm2c_profile_group_t*) b;
+  return (ga->aborts < gb->aborts) - (ga->aborts > gb->aborts);
+}
+
+/* groups the num sorted records; same(a, b) tells if a and b are in the same
+   group. Returns the number of groups, sorted by aborts */
+static uint32_t
+tm2c_profile_group(tm2c_profile_rec_t* sorted, uint32_t num, tm2c_profile_group_t* groups,
+		   int (*cmp)(const void*, const void*))
+{
+  uint32_t i, num_groups = 0;
+  for (i = 0; i < num; i++)
+    {
+      if (i == 0 || cmp(sorted + i - 1, sorted + i) != 0)
+	{
+	  memset(groups + num_groups, 0, sizeof(tm2c_profile_group_t));
+	  groups[num_groups++].first = sorted + i;
+	}
+      tm2c_profile_group_t* g = groups + num_groups - 1;
+      g->num_recs++;
+      g->aborts += sorted[i].count;
+      g->per_conflict[(sorted[i].conflict <= WRITE_AFTER_WRITE) ? sorted[i].conflict : 0] += sorted[i].count;
+    }
+
+  qsort(groups, num_groups, sizeof(tm2c_profile_group_t), tm2c_profile_cmp_aborts);
+  return num_groups;
+}
+
+/* the winner (the address) with the most aborts in the group, or
+   TX_PROFILE_NO_NODE (0) if none is known */
+static nodeid_t
+tm2c_profile_top_winner(tm2c_profile_group_t* g, uint32_t* aborts)
+{
+  uint32_t* per_node = (uint32_t*) calloc(TM2C_MAX_PROCS, sizeof(uint32_t));
+  assert(per_node != NULL);
+  nodeid_t top = TX_PROFILE_NO_NODE;
+  uint32_t i;
+  *aborts = 0;
+  for (i = 0; i < g->num_recs; i++)
+    {
+      nodeid_t w = g->first[i].winner;
+      if (w != TX_PROFILE_NO_NODE && w < TM2C_MAX_PROCS)
+	{
+	  per_node[w] += g->first[i].count;
+	  if (per_node[w] > *aborts)
+	    {
+	      *aborts = per_node[w];
+	      top = w;
+	    }
+	}
+    }
+  free(per_node);
+  return top;
+}
+
+static tm_intern_addr_t
+tm2c_profile_top_address(tm2c_profile_group_t* g, uint32_t* aborts)
+{
+  tm2c_profile_rec_t* sorted = (tm2c_profile_rec_t*) malloc(g->num_recs * sizeof(tm2c_profile_rec_t));
+  assert(sorted != NULL);
+  memcpy(sorted, g->first, g->num_recs * sizeof(tm2c_profile_rec_t));
+  qsort(sorted, g->num_recs, sizeof(tm2c_profile_rec_t), tm2c_profile_cmp_address);
+
+  tm_intern_addr_t top = 0;
+  uint32_t i, sum = 0;
+  *aborts = 0;
+  for (i = 0; i < g->num_recs; i++)
+    {
+      if (sorted[i].winner == TX_PROFILE_NO_NODE)
+	{
+	  continue;		/* no address */
+	}
+      if (i == 0 || sorted[i - 1].address != sorted[i].address || sorted[i - 1].winner == TX_PROFILE_NO_NODE)
+	{
+	  sum = 0;
+	}
+      sum += sorted[i].count;
+      if (sum > *aborts)
+	{
+	  *aborts = sum;
+	  top = sorted[i].address;
+	}
+    }
+  free(sorted);
+  return top;
+}
+
+void
+tm2c_profile_print()
+{
+  if (recs == NULL)
+    {
+      return;
+    }
+
+  uint32_t i, num = 0, num_remote = 0, remote = 0;
+  tm2c_profile_rec_t* sorted = (tm2c_profile_rec_t*) malloc(recs_size * sizeof(tm2c_profile_rec_t));
+  tm2c_profile_group_t* groups = (tm2c_profile_group_t*) malloc(recs_size * sizeof(tm2c_profile_group_t));
+  assert(sorted != NULL && groups != NULL);
+
+  /* the aborts with an address first */
+  for (i = 0; i < recs_size; i++)
+    {
+      if (recs[i].count > 0 && recs[i].winner != TX_PROFILE_NO_NODE)
+	{
+	  sorted[num++] = recs[i];
+	}
+    }
+  for (i = 0; i < recs_size; i++)
+    {
+      if (recs[i].count > 0 && recs[i].winner == TX_PROFILE_NO_NODE)
+	{
+	  remote += recs[i].count;
+	  sorted[num + num_remote++] = recs[i];
+	}
+    }
+
+  printf(":: ABORT PROFILE: TOP %d ADDRESSES ---------------------------\n", TX_PROFILE_TOP);
+  qsort(sorted, num, sizeof(tm2c_profile_rec_t), tm2c_profile_cmp_address);
+  uint32_t num_groups = tm2c_profile_group(sorted, num, groups, tm2c_profile_cmp_address);
+  for (i = 0; i < num_groups && i < TX_PROFILE_TOP; i++)
+    {
+      tm2c_profile_group_t* g = groups + i;
+      uint32_t won;
+      nodeid_t winner = tm2c_profile_top_winner(g, &won);
+      printf("PA| %#-14lx\t: %-8u (RAW %u, WAR %u, WAW %u) | top winner %02d (%u)\n",
+	     (LU) g->first->address, g->aborts, g->per_conflict[READ_AFTER_WRITE],
+	     g->per_conflict[WRITE_AFTER_READ], g->per_conflict[WRITE_AFTER_WRITE],
+	     (int) winner, won);
+    }
+  printf("PA| no address    \t: %-8u (by a contention manager or a validation)\n", remote);
+  if (recs_dropped > 0)
+    {
+      printf("PA| dropped       \t: %-8u (the profile tables were full)\n", recs_dropped);
+    }
+
+  printf(":: ABORT PROFILE: TOP %d SITES -------------------------------\n", TX_PROFILE_TOP);
+  num += num_remote;
+  qsort(sorted, num, sizeof(tm2c_profile_rec_t), tm2c_profile_cmp_site);
+  num_groups = tm2c_profile_group(sorted, num, groups, tm2c_profile_cmp_site);
+  for (i = 0; i < num_groups && i < TX_PROFILE_TOP; i++)
+    {
+      tm2c_profile_group_t* g = groups + i;
+      uint32_t on;
+      tm_intern_addr_t address = tm2c_profile_top_address(g, &on);
+      printf("PS| %s:%u\t: %-8u (RAW %u, WAR %u, WAW %u) | top address %#lx (%u)\n",
+	     g->first->file, g->first->line, g->aborts, g->per_conflict[READ_AFTER_WRITE],
+	     g->per_conflict[WRITE_AFTER_READ], g->per_conflict[WRITE_AFTER_WRITE],
+	     (LU) address, on);
+    }
+
+  free(sorted);
+  free(groups);
+  free(recs);
+  recs = NULL;
+  recs_size = 0;
+}
+
+#endif	/* TX_PROFILE */
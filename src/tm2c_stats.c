@@ -0,0 +1,287 @@
+/*
+ *   File: tm2c_stats.c
+ *   Author: Vasileios Trigonakis <vasileios.trigonakis@epfl.ch>
+ *   Description: machine-readable export of the per-node statistics
+ *                (STATS_EXPORT)
+ *   This file is part of TM2C
+ *
+ *   Copyright (C) 2013  Vasileios Trigonakis
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "tm2c_stats.h"
+
+#if defined(STATS_EXPORT)
+
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "tm2c.h"
+
+#if TM2C_RPC_UKNOWN >= TM2C_STATS_REQ_TYPES
+#  error "TM2C_STATS_REQ_TYPES: too few for the TM2C_RPC types"
+#endif
+
+uint64_t tm2c_stats_msgs_sent = 0;
+uint64_t tm2c_stats_msgs_recv = 0;
+uint64_t tm2c_stats_requests[TM2C_STATS_REQ_TYPES] = {0};
+
+/* names of the requests, indexed by TM2C_RPC_REQ_TYPE */
+static const char* requests_names[] =
+  {
+    "load", "store", "load_rls", "store_finish", "rmv_node", "load_nontx",
+    "store_nontx", "store_inc", "stats", "store_multi", "load_range",
+    "validate", "load_snapshot", "store_commit", "rmw", "rmw_nontx",
+    "irrevoc", "irrevoc_rls", "release", "downgrade", "profile", "histo",
+    "unknown"
+  };
+
+#define STATS_EXPORT_REC_SIZE 8192
+
+static int fd = -1;
+static double time_start;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static char rec[STATS_EXPORT_REC_SIZE];
+static size_t rec_len;
+#if STATS_EXPORT == STATS_EXPORT_CSV
+static char rec_prefix[96];	/* the first columns of every row */
+#endif
+
+#if STATS_EXPORT_PERIOD > 0
+static pthread_t sampler;
+static volatile uint32_t sampler_stop = 0;
+#endif
+
+static void
+tm2c_stats_append(const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(rec + rec_len, STATS_EXPORT_REC_SIZE - rec_len, format, args);
+  va_end(args);
+  if (len > 0)
+    {
+      rec_len += len;
+      if (rec_len >= STATS_EXPORT_REC_SIZE)
+	{
+	  rec_len = STATS_EXPORT_REC_SIZE - 1; /* truncated */
+	}
+    }
+}
+
+/* starts a record of this core, with the lock held */
+static void
+tm2c_stats_begin(uint32_t final)
+{
+  pthread_mutex_lock(&lock);
+  const char* role = is_app_core(NODE_ID()) ? "app" : "dsl";
+  double time = wtime() - time_start;
+  rec_len = 0;
+#if STATS_EXPORT == STATS_EXPORT_CSV
+  snprintf(rec_prefix, sizeof(rec_prefix), "%u,%s,%.3f,%u", NODE_ID(), role, time, final);
+#else
+  tm2c_stats_append("{\"node\":%u,\"role\":\"%s\",\"time\":%.3f,\"final\":%u",
+		    NODE_ID(), role, time, final);
+#endif
+}
+
+/* writes the record and releases the lock */
+static void
+tm2c_stats_end()
+{
+#if STATS_EXPORT != STATS_EXPORT_CSV
+  tm2c_stats_append("}\n");
+#endif
+  if (fd >= 0 && write(fd, rec, rec_len) != (ssize_t) rec_len)
+    {
+      PRINT("stats export: write to %s failed", STATS_EXPORT_FILE);
+    }
+  pthread_mutex_unlock(&lock);
+}
+
+void
+tm2c_stats_u64(const char* name, uint64_t value)
+{
+#if STATS_EXPORT == STATS_EXPORT_CSV
+  tm2c_stats_append("%s,%s,%llu\n", rec_prefix, name, (unsigned long long) value);
+#else
+  tm2c_stats_append(",\"%s\":%llu", name, (unsigned long long) value);
+#endif
+}
+
+void
+tm2c_stats_f64(const char* name, double value)
+{
+#if STATS_EXPORT == STATS_EXPORT_CSV
+  tm2c_stats_append("%s,%s,%.6f\n", rec_prefix, name, value);
+#else
+  tm2c_stats_append(",\"%s\":%.6f", name, value);
+#endif
+}
+
+static void
+tm2c_stats_msgs()
+{
+  tm2c_stats_u64("msgs_sent", tm2c_stats_msgs_sent);
+  tm2c_stats_u64("msgs_recv", tm2c_stats_msgs_recv);
+}
+
+static void
+tm2c_stats_app_fields(tm2c_tx_node_t* stats, double duration)
+{
+  tm2c_stats_u64("commits", stats->tx_committed);
+  tm2c_stats_u64("aborts", stats->tx_aborted);
+  tm2c_stats_u64("aborts_raw", stats->aborts_raw);
+  tm2c_stats_u64("aborts_war", stats->aborts_war);
+  tm2c_stats_u64("aborts_waw", stats->aborts_waw);
+  tm2c_stats_u64("max_retries", stats->max_retries);
+  tm2c_stats_f64("duration", duration);
+  tm2c_stats_msgs();
+#if defined(TX_HISTO)
+  tm2c_histo_stats_export();
+#endif
+}
+
+static void
+tm2c_stats_dsl_fields()
+{
+  uint32_t t;
+  char name[32];
+  for (t = 0; t <= TM2C_RPC_UKNOWN; t++)
+    {
+      if (tm2c_stats_requests[t] > 0)
+	{
+	  snprintf(name, sizeof(name), "requests.%s", requests_names[t]);
+	  tm2c_stats_u64(name, tm2c_stats_requests[t]);
+	}
+    }
+  tm2c_stats_msgs();
+#if defined(DSL_WAITQ)
+  dsl_waitq_stats_export();
+#endif
+}
+
+#if STATS_EXPORT_PERIOD > 0
+static void*
+tm2c_stats_sample(void* arg)
+{
+  double next = time_start + STATS_EXPORT_PERIOD;
+  while (!sampler_stop)
+    {
+      if (wtime() < next)
+	{
+	  usleep(10000);
+	  continue;
+	}
+      next += STATS_EXPORT_PERIOD;
+
+      tm2c_stats_begin(0);
+      if (is_app_core(NODE_ID()))
+	{
+	  tm2c_stats_app_fields(tm2c_tx_node, wtime() - time_start);
+	}
+      else
+	{
+	  tm2c_stats_dsl_fields();
+	}
+      tm2c_stats_end();
+    }
+  return NULL;
+}
+#endif	/* STATS_EXPORT_PERIOD */
+
+static void
+tm2c_stats_stop()
+{
+#if STATS_EXPORT_PERIOD > 0
+  if (!sampler_stop)
+    {
+      sampler_stop = 1;
+      pthread_join(sampler, NULL);
+    }
+#endif
+}
+
+void
+tm2c_stats_create()
+{
+  int f = open(STATS_EXPORT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (f < 0)
+    {
+      PRINT("stats export: cannot create %s", STATS_EXPORT_FILE);
+      return;
+    }
+#if STATS_EXPORT == STATS_EXPORT_CSV
+  const char* header = "node,role,time,final,metric,value\n";
+  if (write(f, header, strlen(header)) < 0)
+    {
+      PRINT("stats export: write to %s failed", STATS_EXPORT_FILE);
+    }
+#endif
+  close(f);
+}
+
+void
+tm2c_stats_init()
+{
+  time_start = wtime();
+  fd = open(STATS_EXPORT_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd < 0)
+    {
+      PRINT("stats export: cannot open %s", STATS_EXPORT_FILE);
+      return;
+    }
+#if STATS_EXPORT_PERIOD > 0
+  if (pthread_create(&sampler, NULL, tm2c_stats_sample, NULL) != 0)
+    {
+      PRINT("stats export: cannot start the sampling thread");
+      sampler_stop = 1;
+    }
+#endif
+}
+
+void
+tm2c_stats_app(tm2c_tx_node_t* stats, double duration)
+{
+  tm2c_stats_stop();
+  tm2c_stats_begin(1);
+  tm2c_stats_app_fields(stats, duration);
+  tm2c_stats_end();
+  close(fd);
+  fd = -1;
+}
+
+void
+tm2c_stats_dsl()
+{
+  tm2c_stats_stop();
+  tm2c_stats_begin(1);
+  tm2c_stats_dsl_fields();
+  tm2c_ht_stats_export(tm2c_ht);
+#if defined(TX_HISTO)
+  if (NODE_ID() == min_dsl_id())
+    {
+      tm2c_histo_stats_export();	/* the merged ones */
+    }
+#endif
+  tm2c_stats_end();
+  close(fd);
+  fd = -1;
+}
+
+#endif	/* STATS_EXPORT */
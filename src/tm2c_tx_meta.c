@@ -70,7 +70,7 @@ tm2c_tx_meta_node_new()
   tm2c_tx_node_temp->aborts_raw = 0;
   tm2c_tx_node_temp->aborts_waw = 0;
 
-#if defined(FAIRCM)
+#if defined(FAIRCM) || defined(DYNAMIC_CM)
   tm2c_tx_node_temp->tx_duration = 1;
 #endif
 
@@ -99,9 +99,26 @@ tm2c_tx_meta_new()
   tm2c_tx_temp->aborts_waw = 0;
   /* tm2c_tx_temp->max_retries = 0; */
 
-#if defined(FAIRCM) || defined(GREEDY)
+#if defined(FAIRCM) || defined(GREEDY) || defined(DYNAMIC_CM)
   tm2c_tx_temp->start_ts = 0;
 #endif
+#if defined(PGAS_MVCC)
+  tm2c_tx_temp->snapshot = 0;
+#endif
+#if defined(IRREVOCABLE)
+  tm2c_tx_temp->irrevocable = 0;
+#endif
+#if defined(TX_NESTING)
+  tm2c_tx_temp->nesting = 0;
+  tm2c_tx_temp->savepoints = (tm2c_tx_savepoint_t*) malloc(TX_NESTING_MAX * sizeof(tm2c_tx_savepoint_t));
+  assert(tm2c_tx_temp->savepoints != NULL);
+  uint32_t s;
+  for (s = 0; s < TX_NESTING_MAX; s++)
+    {
+      tm2c_tx_temp->savepoints[s].contacted = (unsigned short*) calloc(TM2C_MAX_PROCS, sizeof(unsigned short));
+      assert(tm2c_tx_temp->savepoints[s].contacted != NULL);
+    }
+#endif
 
   return tm2c_tx_temp;
 }
@@ -113,6 +130,14 @@ tm2c_tx_meta_free(tm2c_tx_t **tm2c_tx)
   write_set_free((*tm2c_tx)->write_set);
 #endif
   mem_info_free((*tm2c_tx)->mem_info);
+#if defined(TX_NESTING)
+  uint32_t s;
+  for (s = 0; s < TX_NESTING_MAX; s++)
+    {
+      free((*tm2c_tx)->savepoints[s].contacted);
+    }
+  free((*tm2c_tx)->savepoints);
+#endif
   free((*tm2c_tx));
   *tm2c_tx = NULL;
 }